@@ -32,6 +32,7 @@ PlasmaComponents.ListItem {
     property bool activating: ConnectionState == PlasmaNM.Enums.Activating;
     property int  baseHeight: connectionItemBase.height
     property bool expanded: visibleDetails || visiblePasswordDialog
+    property bool pending: ConnectionPath != "" && handler.pendingConnections.indexOf(ConnectionPath) != -1
     property bool predictableWirelessPassword: !Uuid && Type == PlasmaNM.Enums.Wireless &&
                                                (SecurityType == PlasmaNM.Enums.StaticWep || SecurityType == PlasmaNM.Enums.WpaPsk ||
                                                 SecurityType == PlasmaNM.Enums.Wpa2Psk)
@@ -128,7 +129,7 @@ PlasmaComponents.ListItem {
                 verticalCenter: connectionSvgIcon.verticalCenter
             }
             height: units.iconSizes.medium; width: height
-            running: plasmoid.expanded && !stateChangeButton.visible && ConnectionState == PlasmaNM.Enums.Activating
+            running: plasmoid.expanded && !stateChangeButton.visible && (ConnectionState == PlasmaNM.Enums.Activating || pending)
             visible: running
         }
 
@@ -140,6 +141,7 @@ PlasmaComponents.ListItem {
                 rightMargin: Math.round(units.gridUnit / 2)
                 verticalCenter: connectionSvgIcon.verticalCenter
             }
+            enabled: !pending
             opacity: connectionView.currentVisibleButtonIndex == index ? 1 : 0
             visible: opacity != 0
             text: (ConnectionState == PlasmaNM.Enums.Deactivated) ? i18n("Connect") : i18n("Disconnect")
@@ -95,6 +95,7 @@ Item {
             property bool airplaneModeEnabled: false
 
             checked: airplaneModeEnabled
+            enabled: !handler.airplaneModeInProgress
             tooltip: i18n("Enable airplane mode")
             icon: airplaneModeEnabled ? "network-flightmode-on" : "network-flightmode-off"
 
@@ -103,6 +104,16 @@ Item {
                 airplaneModeEnabled = !airplaneModeEnabled;
             }
 
+            Connections {
+                target: handler
+                onAirplaneModeFinished: {
+                    // Radios were restored, so reflect the previous state again
+                    if (!success) {
+                        planeModeSwitchButton.airplaneModeEnabled = !enabled;
+                    }
+                }
+            }
+
             Binding {
                 target: connectionIconProvider
                 property: "airplaneMode"
@@ -24,6 +24,7 @@
 #include "connectioneditordialog.h"
 #include "mobileconnectionwizard.h"
 #include "uiutils.h"
+#include "vpnpluginregistry.h"
 #include "vpnuiplugin.h"
 
 // KDE
@@ -31,8 +32,6 @@
 #include <KPluginFactory>
 #include <KSharedConfig>
 #include <kdeclarative/kdeclarative.h>
-#include <KService>
-#include <KServiceTypeTrader>
 
 #include <NetworkManagerQt/ActiveConnection>
 #include <NetworkManagerQt/Connection>
@@ -93,6 +92,7 @@ KCMNetworkmanagement::KCMNetworkmanagement(QWidget *parent, const QVariantList &
     connect(rootItem, SIGNAL(requestCreateConnection(int,QString,QString,bool)), this, SLOT(onRequestCreateConnection(int,QString,QString,bool)));
     connect(rootItem, SIGNAL(requestExportConnection(QString)), this, SLOT(onRequestExportConnection(QString)));
     connect(rootItem, SIGNAL(requestToChangeConnection(QString,QString)), this, SLOT(onRequestToChangeConnection(QString,QString)));
+    connect(rootItem, SIGNAL(requestToSetAutoconnect(QVariant,bool)), this, SLOT(onRequestToSetAutoconnect(QVariant,bool)));
 
     QVBoxLayout *l = new QVBoxLayout(this);
     l->addWidget(mainWidget);
@@ -202,7 +202,17 @@ void KCMNetworkmanagement::save()
     NetworkManager::Connection::Ptr connection = NetworkManager::findConnection(m_currentConnectionPath);
 
     if (connection) {
-        m_handler->updateConnection(connection, m_tabWidget->setting());
+        const NMVariantMapMap settings = m_tabWidget->setting();
+        // NetworkManager replaces the whole connection on update, so it's either all settings or nothing
+        const NMVariantMapMap changedSettings = m_tabWidget->changedSettings(settings);
+        if (changedSettings.isEmpty()) {
+            qCDebug(PLASMA_NM) << "Connection" << connection->name() << "not changed, skipping update";
+        } else {
+            qCDebug(PLASMA_NM) << "Updating connection" << connection->name() << "changed settings:" << changedSettings.keys();
+            m_pendingSavedSettings = settings;
+            connect(connection.data(), &NetworkManager::Connection::updated, this, &KCMNetworkmanagement::onConnectionUpdated, Qt::UniqueConnection);
+            m_handler->updateConnection(connection, settings);
+        }
     }
 
     kcmChanged(false);
@@ -228,6 +238,26 @@ void KCMNetworkmanagement::onConnectionAdded(const QString &connection)
     }
 }
 
+void KCMNetworkmanagement::onConnectionUpdated()
+{
+    NetworkManager::Connection *connection = qobject_cast<NetworkManager::Connection*>(sender());
+    if (!connection) {
+        return;
+    }
+
+    disconnect(connection, &NetworkManager::Connection::updated, this, &KCMNetworkmanagement::onConnectionUpdated);
+
+    if (m_tabWidget && connection->path() == m_currentConnectionPath) {
+        if (!m_pendingSavedSettings.isEmpty()) {
+            m_tabWidget->setSavedSetting(m_pendingSavedSettings);
+        } else {
+            // Updated as part of a selection, the editor would save the old settings back otherwise
+            loadConnectionSettings(connection->settings());
+        }
+    }
+    m_pendingSavedSettings.clear();
+}
+
 void KCMNetworkmanagement::onRequestCreateConnection(int connectionType, const QString &vpnType, const QString &specificType, bool shared)
 {
     NetworkManager::ConnectionSettings::ConnectionType type = static_cast<NetworkManager::ConnectionSettings::ConnectionType>(connectionType);
@@ -346,9 +376,7 @@ void KCMNetworkmanagement::onRequestExportConnection(const QString &connectionPa
     qCDebug(PLASMA_NM) << "Exporting VPN connection" << connection->name() << "type:" << vpnSetting->serviceType();
 
     QString error;
-    VpnUiPlugin * vpnPlugin = KServiceTypeTrader::createInstanceFromQuery<VpnUiPlugin>(QStringLiteral("PlasmaNetworkManagement/VpnUiPlugin"),
-                                                                                       QStringLiteral("[X-NetworkManager-Services]=='%1'").arg(vpnSetting->serviceType()),
-                                                                                       this, QVariantList(), &error);
+    VpnUiPlugin * vpnPlugin = VpnPluginRegistry::self()->plugin(vpnSetting->serviceType(), &error);
 
     if (vpnPlugin) {
         if (vpnPlugin->suggestedFileName(connSettings).isEmpty()) { // this VPN doesn't support export
@@ -366,7 +394,6 @@ void KCMNetworkmanagement::onRequestExportConnection(const QString &connectionPa
                 // TODO display success
             }
         }
-        delete vpnPlugin;
     } else {
         qCWarning(PLASMA_NM) << "Error getting VpnUiPlugin for export:" << error;
     }
@@ -387,6 +414,30 @@ void KCMNetworkmanagement::onRequestToChangeConnection( const QString &connectio
     QMetaObject::invokeMethod(rootItem, "selectConnection", Q_ARG(QVariant, connectionName), Q_ARG(QVariant, connectionPath));
 }
 
+void KCMNetworkmanagement::onRequestToSetAutoconnect(const QVariant &connections, bool autoconnect)
+{
+    QMap<QString, NMVariantMapMap> updatedConnections;
+    Q_FOREACH (const QString &connectionPath, connections.toStringList()) {
+        NetworkManager::Connection::Ptr connection = NetworkManager::findConnection(connectionPath);
+        if (!connection || connection->settings()->autoconnect() == autoconnect) {
+            continue;
+        }
+
+        // Secrets are not part of the settings, NetworkManager keeps the stored ones
+        NetworkManager::ConnectionSettings settings(connection->settings());
+        settings.setAutoconnect(autoconnect);
+        updatedConnections.insert(connectionPath, settings.toMap());
+
+        if (connectionPath == m_currentConnectionPath) {
+            connect(connection.data(), &NetworkManager::Connection::updated, this, &KCMNetworkmanagement::onConnectionUpdated, Qt::UniqueConnection);
+        }
+    }
+
+    if (!updatedConnections.isEmpty()) {
+        m_handler->updateConnections(updatedConnections);
+    }
+}
+
 void KCMNetworkmanagement::onSelectedConnectionChanged(const QString &connectionPath)
 {
     if (connectionPath.isEmpty()) {
@@ -430,6 +481,8 @@ void KCMNetworkmanagement::kcmChanged(bool kcmChanged)
 
 void KCMNetworkmanagement::loadConnectionSettings(const NetworkManager::ConnectionSettings::Ptr& connectionSettings)
 {
+    m_pendingSavedSettings.clear();
+
     if (m_tabWidget) {
         m_tabWidget->setConnection(connectionSettings);
     } else {
@@ -456,29 +509,19 @@ void KCMNetworkmanagement::loadConnectionSettings(const NetworkManager::Connecti
 void KCMNetworkmanagement::importVpn()
 {
     // get the list of supported extensions
-    const KService::List services = KServiceTypeTrader::self()->query("PlasmaNetworkManagement/VpnUiPlugin");
-    QString extensions;
-    Q_FOREACH (const KService::Ptr &service, services) {
-        VpnUiPlugin * vpnPlugin = service->createInstance<VpnUiPlugin>(this);
-        if (vpnPlugin) {
-            extensions += vpnPlugin->supportedFileExtensions() % QStringLiteral(" ");
-            delete vpnPlugin;
-        }
-    }
+    const QString extensions = VpnPluginRegistry::self()->fileExtensions();
 
-    const QString &filename = QFileDialog::getOpenFileName(this, i18n("Import VPN Connection"), QDir::homePath(), extensions.simplified());
+    const QString &filename = QFileDialog::getOpenFileName(this, i18n("Import VPN Connection"), QDir::homePath(), extensions);
 
     if (!filename.isEmpty()) {
-        const KService::List services = KServiceTypeTrader::self()->query("PlasmaNetworkManagement/VpnUiPlugin");
-
         QFileInfo fi(filename);
         const QString ext = QStringLiteral("*.") % fi.suffix();
         qCDebug(PLASMA_NM) << "Importing VPN connection " << filename << "extension:" << ext;
 
-        Q_FOREACH (const KService::Ptr &service, services) {
-            VpnUiPlugin * vpnPlugin = service->createInstance<VpnUiPlugin>(this);
-            if (vpnPlugin && vpnPlugin->supportedFileExtensions().contains(ext)) {
-                qCDebug(PLASMA_NM) << "Found VPN plugin" << service->name() << ", type:" << service->property("X-NetworkManager-Services", QVariant::String).toString();
+        Q_FOREACH (const QString &serviceType, VpnPluginRegistry::self()->serviceTypesForExtension(ext)) {
+            VpnUiPlugin * vpnPlugin = VpnPluginRegistry::self()->plugin(serviceType);
+            if (vpnPlugin) {
+                qCDebug(PLASMA_NM) << "Found VPN plugin for type:" << serviceType;
 
                 NMVariantMapMap connection = vpnPlugin->importConnectionSettings(filename);
 
@@ -496,11 +539,8 @@ void KCMNetworkmanagement::importVpn()
                 if (connection.isEmpty()) { // the "positive" part will arrive with connectionAdded
                     // TODO display success
                 } else {
-                    delete vpnPlugin;
                     break; // stop iterating over the plugins if the import produced at least some output
                 }
-
-                delete vpnPlugin;
             }
         }
     }
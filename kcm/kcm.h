@@ -43,10 +43,12 @@ public Q_SLOTS:
 
 private Q_SLOTS:
     void onConnectionAdded(const QString &connection);
+    void onConnectionUpdated();
     void onSelectedConnectionChanged(const QString &connectionPath);
     void onRequestCreateConnection(int connectionType, const QString &vpnType, const QString &specificType, bool shared);
     void onRequestExportConnection(const QString &connectionPath);
     void onRequestToChangeConnection(const QString &connectionName, const QString &connectionPath);
+    void onRequestToSetAutoconnect(const QVariant &connections, bool autoconnect);
 
 private:
     void addConnection(const NetworkManager::ConnectionSettings::Ptr &connectionSettings);
@@ -57,6 +59,8 @@ private:
 
     QString m_currentConnectionPath;
     QString m_createdConnectionUuid;
+    // Settings sent by the last save, the editor takes them as saved once NetworkManager applied them
+    NMVariantMapMap m_pendingSavedSettings;
     Handler *m_handler;
     ConnectionEditorTabWidget *m_tabWidget;
     QTimer *m_timer;
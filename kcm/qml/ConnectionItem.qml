@@ -27,12 +27,18 @@ import org.kde.plasma.networkmanagement 0.2 as PlasmaNM
 ListItem {
     id: connectionItem
 
-    checked: mouseArea.containsMouse || ConnectionPath === connectionView.currentConnectionPath
+    property bool selected: connectionView.selectedConnections.indexOf(ConnectionPath) != -1
+    // Actions of the item apply to all selected connections
+    property bool partOfSelection: selected && connectionView.selectedConnections.length > 1
+
+    checked: mouseArea.containsMouse || selected || ConnectionPath === connectionView.currentConnectionPath
     height: connectionItemBase.height
 
     signal aboutToChangeConnection(bool exportable, string name, string path)
     signal aboutToExportConnection(string path)
     signal aboutToRemoveConnection(string name, string path)
+    signal aboutToToggleConnection(string path)
+    signal aboutToSetAutoconnect(bool autoconnect)
 
     Item {
         id: connectionItemBase
@@ -111,7 +117,7 @@ ListItem {
 
         PlasmaComponents.MenuItem {
             text: ConnectionState == PlasmaNM.Enums.Deactivated ? i18n("Connect") : i18n("Disconnect")
-            visible: ItemType == 1
+            visible: ItemType == 1 && !partOfSelection
             onClicked: {
                 if (ConnectionState == PlasmaNM.Enums.Deactivated) {
                     handler.activateConnection(ConnectionPath, DevicePath, SpecificPath);
@@ -121,9 +127,33 @@ ListItem {
             }
         }
 
+        PlasmaComponents.MenuItem {
+            text: i18n("Connect Selected")
+            visible: partOfSelection
+            onClicked: handler.activateConnections(connectionView.selectedConnections)
+        }
+
+        PlasmaComponents.MenuItem {
+            text: i18n("Disconnect Selected")
+            visible: partOfSelection
+            onClicked: handler.deactivateConnections(connectionView.selectedConnections)
+        }
+
+        PlasmaComponents.MenuItem {
+            text: i18n("Connect Selected Automatically")
+            visible: partOfSelection
+            onClicked: aboutToSetAutoconnect(true)
+        }
+
+        PlasmaComponents.MenuItem {
+            text: i18n("Don't Connect Selected Automatically")
+            visible: partOfSelection
+            onClicked: aboutToSetAutoconnect(false)
+        }
+
         PlasmaComponents.MenuItem {
             icon: "list-remove"
-            text: i18n("Delete");
+            text: partOfSelection ? i18n("Delete Selected") : i18n("Delete");
 
             onClicked: {
                 aboutToRemoveConnection(Name, ConnectionPath)
@@ -146,7 +176,9 @@ ListItem {
         hoverEnabled: true
 
         onClicked: {
-            if (mouse.button === Qt.LeftButton) {
+            if (mouse.button === Qt.LeftButton && (mouse.modifiers & Qt.ControlModifier)) {
+                aboutToToggleConnection(ConnectionPath)
+            } else if (mouse.button === Qt.LeftButton) {
                 aboutToChangeConnection(KcmVpnConnectionExportable, Name, ConnectionPath)
             } else if (mouse.button == Qt.RightButton) {
                 connectionItemMenu.open(mouse.x, mouse.y)
@@ -35,6 +35,7 @@ Item {
     signal requestCreateConnection(int type, string vpnType, string specificType, bool shared)
     signal requestExportConnection(string connection)
     signal requestToChangeConnection(string name, string path)
+    signal requestToSetAutoconnect(var connections, bool autoconnect)
 
     Rectangle {
         id: background
@@ -90,6 +91,8 @@ Item {
             property bool currentConnectionExportable: false
             property string currentConnectionName
             property string currentConnectionPath
+            // Connections selected with Ctrl+click, operations on them are sent as one batch
+            property var selectedConnections: []
 
             anchors.fill: parent
             clip: true
@@ -100,6 +103,7 @@ Item {
             section.delegate: Header { text: section }
             delegate: ConnectionItem {
                 onAboutToChangeConnection: {
+                    connectionView.selectedConnections = []
                     // Shouldn't be problem to set this in advance
                     connectionView.currentConnectionExportable = exportable
                     if (connectionModified) {
@@ -115,9 +119,25 @@ Item {
                 }
 
                 onAboutToRemoveConnection: {
-                    deleteConfirmationDialog.connectionName = name
-                    deleteConfirmationDialog.connectionPath = path
-                    deleteConfirmationDialog.open()
+                    removeConnections(name, path)
+                }
+
+                onAboutToSetAutoconnect: {
+                    requestToSetAutoconnect(connectionView.selectedConnections, autoconnect)
+                }
+
+                onAboutToToggleConnection: {
+                    var selection = connectionView.selectedConnections.slice()
+                    if (!selection.length && connectionView.currentConnectionPath.length && connectionView.currentConnectionPath != path) {
+                        selection.push(connectionView.currentConnectionPath)
+                    }
+                    var position = selection.indexOf(path)
+                    if (position == -1) {
+                        selection.push(path)
+                    } else {
+                        selection.splice(position, 1)
+                    }
+                    connectionView.selectedConnections = selection
                 }
             }
 
@@ -151,14 +171,16 @@ Item {
         QtControls.ToolButton {
             id: removeConnectionButton
 
-            enabled: connectionView.currentConnectionPath && connectionView.currentConnectionPath.length
+            enabled: (connectionView.currentConnectionPath && connectionView.currentConnectionPath.length) || connectionView.selectedConnections.length
             iconName: "list-remove"
             tooltip: i18n("Remove selected connection")
 
             onClicked: {
-                deleteConfirmationDialog.connectionName = connectionView.currentConnectionName
-                deleteConfirmationDialog.connectionPath = connectionView.currentConnectionPath
-                deleteConfirmationDialog.open()
+                if (connectionView.selectedConnections.length) {
+                    removeConnections("", "")
+                } else {
+                    removeConnections(connectionView.currentConnectionName, connectionView.currentConnectionPath)
+                }
             }
         }
 
@@ -180,13 +202,24 @@ Item {
 
         property string connectionName
         property string connectionPath
+        property var connectionPaths: []
 
         icon: StandardIcon.Question
         standardButtons: StandardButton.Ok | StandardButton.Cancel
-        title: i18nc("@title:window", "Remove Connection")
-        text: i18n("Do you want to remove the connection '%1'?", connectionName)
+        title: connectionPaths.length ? i18nc("@title:window", "Remove Connections") : i18nc("@title:window", "Remove Connection")
+        text: connectionPaths.length ? i18np("Do you want to remove %1 connection?", "Do you want to remove %1 connections?", connectionPaths.length)
+                                         : i18n("Do you want to remove the connection '%1'?", connectionName)
 
         onAccepted: {
+            if (connectionPaths.length) {
+                if (connectionPaths.indexOf(connectionView.currentConnectionPath) != -1) {
+                    deselectConnections()
+                }
+                connectionView.selectedConnections = []
+                handler.removeConnections(connectionPaths)
+                return
+            }
+
             if (connectionPath == connectionView.currentConnectionPath) {
                 // Deselect now non-existing connection
                 deselectConnections()
@@ -203,6 +236,19 @@ Item {
         }
     }
 
+    function removeConnections(connectionName, connectionPath) {
+        // Removing a connection which is part of the selection removes the whole selection
+        if (connectionView.selectedConnections.length &&
+            (!connectionPath.length || connectionView.selectedConnections.indexOf(connectionPath) != -1)) {
+            deleteConfirmationDialog.connectionPaths = connectionView.selectedConnections
+        } else {
+            deleteConfirmationDialog.connectionPaths = []
+        }
+        deleteConfirmationDialog.connectionName = connectionName
+        deleteConfirmationDialog.connectionPath = connectionPath
+        deleteConfirmationDialog.open()
+    }
+
     function deselectConnections() {
         connectionView.currentConnectionPath = ""
     }
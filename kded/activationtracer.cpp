@@ -0,0 +1,292 @@
+/*
+    Copyright 2026 agent <agent@local>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "activationtracer.h"
+#include "debug.h"
+
+#include <NetworkManagerQt/Manager>
+
+#include <QElapsedTimer>
+
+// Number of finished activations which are remembered
+#define ACTIVATION_TRACES_LIMIT 50
+
+ActivationTracer::ActivationTracer(QObject *parent)
+    : QObject(parent)
+{
+    Q_FOREACH (const NetworkManager::Device::Ptr &device, NetworkManager::networkInterfaces()) {
+        addDevice(device);
+    }
+
+    connect(NetworkManager::notifier(), &NetworkManager::Notifier::deviceAdded, this, &ActivationTracer::deviceAdded);
+    connect(NetworkManager::notifier(), &NetworkManager::Notifier::activeConnectionAdded, this, &ActivationTracer::activeConnectionAdded);
+}
+
+ActivationTracer::~ActivationTracer()
+{
+}
+
+QVariantList ActivationTracer::traces() const
+{
+    QVariantList result;
+    Q_FOREACH (const Trace &trace, m_traces) {
+        result << traceToMap(trace);
+    }
+    return result;
+}
+
+QVariantMap ActivationTracer::lastTrace(const QString &uuid) const
+{
+    for (int i = m_traces.size() - 1; i >= 0; --i) {
+        if (m_traces.at(i).uuid == uuid) {
+            return traceToMap(m_traces.at(i));
+        }
+    }
+    return QVariantMap();
+}
+
+void ActivationTracer::activationRequested(const QString &connectionPath, qlonglong timestamp)
+{
+    // A new request always starts a new trace, the previous one would never finish anyway
+    Trace trace;
+    trace.connectionPath = connectionPath;
+    trace.requested = timestamp;
+
+    NetworkManager::Connection::Ptr connection = NetworkManager::findConnection(connectionPath);
+    if (connection) {
+        trace.uuid = connection->uuid();
+        trace.name = connection->name();
+    }
+
+    m_running.insert(connectionPath, trace);
+}
+
+void ActivationTracer::activationReplied(const QString &connectionPath, qlonglong timestamp, const QString &error)
+{
+    if (!m_running.contains(connectionPath)) {
+        return;
+    }
+
+    Trace &trace = m_running[connectionPath];
+    trace.replied = timestamp;
+
+    if (!error.isEmpty()) {
+        trace.error = error;
+        finishTrace(connectionPath, false);
+    }
+}
+
+void ActivationTracer::secretsRequested(const QString &connectionPath)
+{
+    if (m_running.contains(connectionPath)) {
+        m_running[connectionPath].authStarted = now();
+    }
+}
+
+void ActivationTracer::secretsRequestFinished(const QString &connectionPath)
+{
+    if (!m_running.contains(connectionPath)) {
+        return;
+    }
+
+    Trace &trace = m_running[connectionPath];
+    if (trace.authStarted) {
+        trace.authTime += now() - trace.authStarted;
+        trace.authStarted = 0;
+    }
+}
+
+void ActivationTracer::activeConnectionAdded(const QString &path)
+{
+    NetworkManager::ActiveConnection::Ptr activeConnection = NetworkManager::findActiveConnection(path);
+    if (!activeConnection || !activeConnection->connection()) {
+        return;
+    }
+
+    const QString connectionPath = activeConnection->connection()->path();
+    // Activations not requested through the applet (e.g. autoconnect) are traced too
+    if (!m_running.contains(connectionPath)) {
+        Trace trace;
+        trace.connectionPath = connectionPath;
+        m_running.insert(connectionPath, trace);
+    }
+
+    Trace &trace = m_running[connectionPath];
+    trace.uuid = activeConnection->uuid();
+    trace.name = activeConnection->id();
+    trace.started = now();
+
+    if (!activeConnection->devices().isEmpty()) {
+        trace.device = activeConnection->devices().first();
+        if (!activeConnection->vpn()) {
+            m_devices.insert(trace.device, connectionPath);
+        }
+    }
+
+    activeConnection->setProperty("connectionPath", connectionPath);
+    connect(activeConnection.data(), &NetworkManager::ActiveConnection::stateChanged, this, &ActivationTracer::activeConnectionStateChanged);
+}
+
+void ActivationTracer::activeConnectionStateChanged(NetworkManager::ActiveConnection::State state)
+{
+    NetworkManager::ActiveConnection *activeConnection = qobject_cast<NetworkManager::ActiveConnection*>(sender());
+    if (!activeConnection) {
+        return;
+    }
+
+    const QString connectionPath = activeConnection->property("connectionPath").toString();
+    if (state == NetworkManager::ActiveConnection::Activated) {
+        finishTrace(connectionPath, true);
+    } else if (state == NetworkManager::ActiveConnection::Deactivated) {
+        finishTrace(connectionPath, false);
+    }
+
+    if (state == NetworkManager::ActiveConnection::Activated || state == NetworkManager::ActiveConnection::Deactivated) {
+        disconnect(activeConnection, &NetworkManager::ActiveConnection::stateChanged, this, &ActivationTracer::activeConnectionStateChanged);
+    }
+}
+
+void ActivationTracer::deviceAdded(const QString &uni)
+{
+    NetworkManager::Device::Ptr device = NetworkManager::findNetworkInterface(uni);
+    if (device) {
+        addDevice(device);
+    }
+}
+
+void ActivationTracer::addDevice(const NetworkManager::Device::Ptr &device)
+{
+    connect(device.data(), &NetworkManager::Device::stateChanged, this, &ActivationTracer::deviceStateChanged);
+}
+
+void ActivationTracer::deviceStateChanged(NetworkManager::Device::State newstate, NetworkManager::Device::State oldstate, NetworkManager::Device::StateChangeReason reason)
+{
+    Q_UNUSED(oldstate);
+    Q_UNUSED(reason);
+
+    NetworkManager::Device *device = qobject_cast<NetworkManager::Device*>(sender());
+    if (!device || !m_devices.contains(device->uni())) {
+        return;
+    }
+
+    const QString connectionPath = m_devices.value(device->uni());
+    if (!m_running.contains(connectionPath)) {
+        m_devices.remove(device->uni());
+        return;
+    }
+
+    QString phase;
+    switch (newstate) {
+    case NetworkManager::Device::Preparing:
+        phase = QStringLiteral("prepare");
+        break;
+    case NetworkManager::Device::ConfiguringHardware:
+        phase = QStringLiteral("config");
+        break;
+    case NetworkManager::Device::NeedAuth:
+        phase = QStringLiteral("need-auth");
+        break;
+    case NetworkManager::Device::ConfiguringIp:
+        phase = QStringLiteral("ip-config");
+        break;
+    case NetworkManager::Device::CheckingIp:
+        phase = QStringLiteral("ip-check");
+        break;
+    case NetworkManager::Device::WaitingForSecondaries:
+        phase = QStringLiteral("secondaries");
+        break;
+    case NetworkManager::Device::Activated:
+        phase = QStringLiteral("activated");
+        break;
+    case NetworkManager::Device::Failed:
+        phase = QStringLiteral("failed");
+        break;
+    default:
+        return;
+    }
+
+    m_running[connectionPath].phases << qMakePair(phase, now());
+}
+
+void ActivationTracer::finishTrace(const QString &connectionPath, bool success)
+{
+    if (!m_running.contains(connectionPath)) {
+        return;
+    }
+
+    Trace trace = m_running.take(connectionPath);
+    trace.finished = now();
+    trace.success = success;
+    if (trace.authStarted) {
+        trace.authTime += trace.finished - trace.authStarted;
+        trace.authStarted = 0;
+    }
+    m_devices.remove(trace.device);
+
+    m_traces << trace;
+    while (m_traces.size() > ACTIVATION_TRACES_LIMIT) {
+        m_traces.removeFirst();
+    }
+
+    const QVariantMap map = traceToMap(trace);
+    qCDebug(PLASMA_NM) << "Activation of" << trace.name << "finished:" << map;
+    Q_EMIT traceFinished(map);
+}
+
+QVariantMap ActivationTracer::traceToMap(const Trace &trace) const
+{
+    // Everything is relative to the first known moment of the activation
+    const qint64 begin = trace.requested ? trace.requested : trace.started;
+
+    QVariantMap map;
+    map.insert(QStringLiteral("uuid"), trace.uuid);
+    map.insert(QStringLiteral("name"), trace.name);
+    map.insert(QStringLiteral("connection"), trace.connectionPath);
+    map.insert(QStringLiteral("device"), trace.device);
+    map.insert(QStringLiteral("timestamp"), trace.created.toMSecsSinceEpoch());
+    map.insert(QStringLiteral("success"), trace.success);
+    map.insert(QStringLiteral("auth"), trace.authTime);
+    if (trace.finished) {
+        map.insert(QStringLiteral("total"), trace.finished - begin);
+    }
+    if (trace.replied) {
+        map.insert(QStringLiteral("reply"), trace.replied - begin);
+    }
+    if (!trace.error.isEmpty()) {
+        map.insert(QStringLiteral("error"), trace.error);
+    }
+
+    QVariantMap phases;
+    for (int i = 0; i < trace.phases.size(); ++i) {
+        phases.insert(trace.phases.at(i).first, trace.phases.at(i).second - begin);
+    }
+    map.insert(QStringLiteral("phases"), phases);
+
+    return map;
+}
+
+qint64 ActivationTracer::now()
+{
+    // Monotonic, so changes of the wall clock don't skew the measured times. The clock is
+    // system wide, timestamps sent by the applet can be compared with it
+    QElapsedTimer timer;
+    timer.start();
+    return timer.msecsSinceReference();
+}
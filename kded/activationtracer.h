@@ -0,0 +1,104 @@
+/*
+    Copyright 2026 agent <agent@local>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLASMA_NM_ACTIVATION_TRACER_H
+#define PLASMA_NM_ACTIVATION_TRACER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QPair>
+#include <QVariantMap>
+
+#include <NetworkManagerQt/ActiveConnection>
+#include <NetworkManagerQt/Device>
+
+/**
+ * Records how long each phase of a connection activation took, from the request sent
+ * by the applet through device state changes up to the moment the connection is activated.
+ * Finished traces are kept in a bounded ring so the slow phases can be found afterwards.
+ */
+class ActivationTracer : public QObject
+{
+Q_OBJECT
+public:
+    explicit ActivationTracer(QObject *parent = 0);
+    virtual ~ActivationTracer();
+
+    /**
+     * Finished traces, the oldest first
+     */
+    QVariantList traces() const;
+    /**
+     * Last finished trace of given connection or an empty map
+     * @uuid - uuid of the connection
+     */
+    QVariantMap lastTrace(const QString &uuid) const;
+
+public Q_SLOTS:
+    void activationRequested(const QString &connectionPath, qlonglong timestamp);
+    void activationReplied(const QString &connectionPath, qlonglong timestamp, const QString &error);
+    void secretsRequested(const QString &connectionPath);
+    void secretsRequestFinished(const QString &connectionPath);
+
+Q_SIGNALS:
+    void traceFinished(const QVariantMap &trace);
+
+private Q_SLOTS:
+    void activeConnectionAdded(const QString &path);
+    void activeConnectionStateChanged(NetworkManager::ActiveConnection::State state);
+    void deviceAdded(const QString &uni);
+    void deviceStateChanged(NetworkManager::Device::State newstate, NetworkManager::Device::State oldstate, NetworkManager::Device::StateChangeReason reason);
+
+private:
+    struct Trace {
+        Trace() : created(QDateTime::currentDateTime()), requested(0), replied(0), started(0), finished(0), authStarted(0), authTime(0), success(false) {}
+
+        // Wall clock time for display only, durations are measured by now()
+        QDateTime created;
+
+        QString uuid;
+        QString name;
+        QString connectionPath;
+        QString device;
+        QString error;
+        qint64 requested;
+        qint64 replied;
+        qint64 started;
+        qint64 finished;
+        qint64 authStarted;
+        qint64 authTime;
+        bool success;
+        QList<QPair<QString, qint64> > phases;
+    };
+
+    // Traces of activations in progress, keyed by path of the connection settings
+    QHash<QString, Trace> m_running;
+    // Device uni mapped to path of the connection being activated on it
+    QHash<QString, QString> m_devices;
+    QList<Trace> m_traces;
+
+    void addDevice(const NetworkManager::Device::Ptr &device);
+    void finishTrace(const QString &connectionPath, bool success);
+    QVariantMap traceToMap(const Trace &trace) const;
+    static qint64 now();
+};
+
+#endif // PLASMA_NM_ACTIVATION_TRACER_H
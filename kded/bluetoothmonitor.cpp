@@ -36,6 +36,12 @@
 BluetoothMonitor::BluetoothMonitor(QObject * parent)
     : QObject(parent)
 {
+    Q_FOREACH (const NetworkManager::Connection::Ptr &con, NetworkManager::listConnections()) {
+        addConnection(con);
+    }
+
+    connect(NetworkManager::settingsNotifier(), &NetworkManager::SettingsNotifier::connectionAdded, this, &BluetoothMonitor::connectionAdded);
+    connect(NetworkManager::settingsNotifier(), &NetworkManager::SettingsNotifier::connectionRemoved, this, &BluetoothMonitor::connectionRemoved);
 }
 
 BluetoothMonitor::~BluetoothMonitor()
@@ -58,16 +64,7 @@ bool BluetoothMonitor::bluetoothConnectionExists(const QString &bdAddr, const QS
         return false;
     }
 
-    Q_FOREACH (const NetworkManager::Connection::Ptr &con, NetworkManager::listConnections()) {
-        if (con && con->settings() && con->settings()->connectionType() == NetworkManager::ConnectionSettings::Bluetooth) {
-            NetworkManager::BluetoothSetting::Ptr btSetting = con->settings()->setting(NetworkManager::Setting::Bluetooth).staticCast<NetworkManager::BluetoothSetting>();
-            if (btSetting->profileType() == profile && btSetting->bluetoothAddress() == NetworkManager::macAddressFromString(bdAddr)) {
-                return true;
-            }
-        }
-    }
-
-    return false;
+    return m_connections.contains(indexKey(NetworkManager::macAddressFromString(bdAddr), profile));
 }
 
 void BluetoothMonitor::addBluetoothConnection(const QString &bdAddr, const QString &service, const QString &connectionName)
@@ -104,7 +101,7 @@ void BluetoothMonitor::addBluetoothConnection(const QString &bdAddr, const QStri
     else if (service == QLatin1String("dun")) {
         QPointer<MobileConnectionWizard> mobileConnectionWizard = new MobileConnectionWizard(NetworkManager::ConnectionSettings::Bluetooth);
         connect(mobileConnectionWizard.data(), &MobileConnectionWizard::accepted,
-                [bdAddr, connectionName, mobileConnectionWizard, this] () {
+                [bdAddr, connectionName, mobileConnectionWizard] () {
                     if (mobileConnectionWizard->getError() == MobileProviders::Success) {
                         qCDebug(PLASMA_NM) << "Mobile broadband wizard finished:" << mobileConnectionWizard->type() << mobileConnectionWizard->args();
                         if (mobileConnectionWizard->args().count() == 2) { //GSM or CDMA
@@ -144,3 +141,52 @@ void BluetoothMonitor::addBluetoothConnection(const QString &bdAddr, const QStri
     }
 #endif
 }
+
+void BluetoothMonitor::connectionAdded(const QString &path)
+{
+    NetworkManager::Connection::Ptr con = NetworkManager::findConnection(path);
+    if (con) {
+        addConnection(con);
+    }
+}
+
+void BluetoothMonitor::connectionRemoved(const QString &path)
+{
+    if (m_connectionKeys.contains(path)) {
+        m_connections.remove(m_connectionKeys.take(path), path);
+    }
+}
+
+void BluetoothMonitor::connectionUpdated()
+{
+    NetworkManager::Connection *con = qobject_cast<NetworkManager::Connection*>(sender());
+    if (con) {
+        // Address or profile might have changed
+        connectionRemoved(con->path());
+        connectionAdded(con->path());
+    }
+}
+
+void BluetoothMonitor::addConnection(const NetworkManager::Connection::Ptr &connection)
+{
+    connect(connection.data(), &NetworkManager::Connection::updated, this, &BluetoothMonitor::connectionUpdated, Qt::UniqueConnection);
+
+    NetworkManager::ConnectionSettings::Ptr settings = connection->settings();
+    if (!settings || settings->connectionType() != NetworkManager::ConnectionSettings::Bluetooth) {
+        return;
+    }
+
+    NetworkManager::BluetoothSetting::Ptr btSetting = settings->setting(NetworkManager::Setting::Bluetooth).staticCast<NetworkManager::BluetoothSetting>();
+    if (!btSetting) {
+        return;
+    }
+
+    const QString key = indexKey(btSetting->bluetoothAddress(), btSetting->profileType());
+    m_connections.insert(key, connection->path());
+    m_connectionKeys.insert(connection->path(), key);
+}
+
+QString BluetoothMonitor::indexKey(const QByteArray &bdAddr, int profile)
+{
+    return QString::number(profile) + QLatin1Char('|') + QString::fromLatin1(bdAddr.toHex());
+}
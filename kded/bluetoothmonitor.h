@@ -28,8 +28,11 @@
 #include <ModemManagerQt/manager.h>
 #endif
 
+#include <QHash>
 #include <QObject>
 
+#include <NetworkManagerQt/Connection>
+
 class BluetoothMonitor: public QObject
 {
 Q_OBJECT
@@ -39,5 +42,22 @@ public:
 
     bool bluetoothConnectionExists(const QString &bdAddr, const QString &service);
     void addBluetoothConnection(const QString &bdAddr, const QString &service, const QString &connectionName);
+
+private Q_SLOTS:
+    void connectionAdded(const QString &path);
+    void connectionRemoved(const QString &path);
+    void connectionUpdated();
+
+private:
+    void addConnection(const NetworkManager::Connection::Ptr &connection);
+    /**
+     * @return key of the index for given Bluetooth address and profile
+     */
+    static QString indexKey(const QByteArray &bdAddr, int profile);
+
+    // (bdaddr, profile) -> paths of Bluetooth connections
+    QMultiHash<QString, QString> m_connections;
+    // path -> key in m_connections
+    QHash<QString, QString> m_connectionKeys;
 };
 #endif
@@ -24,6 +24,8 @@
 #include "modemmonitor.h"
 
 #include <QDBusPendingReply>
+#include <QPointer>
+#include <QSet>
 
 #include <KConfigGroup>
 #include <KLocalizedString>
@@ -34,6 +36,7 @@
 #include <NetworkManagerQt/Connection>
 #include <NetworkManagerQt/GsmSetting>
 #include <NetworkManagerQt/Manager>
+#include <NetworkManagerQt/Settings>
 
 #include <ModemManager/ModemManager.h>
 #include <ModemManagerQt/Manager>
@@ -42,18 +45,22 @@
 
 #include "pindialog.h"
 
+// Silent unlock is only tried while enough attempts are left to not lock the SIM
+#define SILENT_UNLOCK_MIN_RETRIES 3
+
 class ModemMonitorPrivate
 {
 public:
-    QWeakPointer<PinDialog> dialog;
+    // One PIN dialog per modem so several modems can be unlocked at once
+    QHash<QString, QPointer<PinDialog> > dialogs;
+    // Modems a stored PIN was already tried for
+    QSet<QString> silentUnlockTried;
+    QSet<QString> silentUnlockPending;
 };
 
 ModemMonitor::ModemMonitor(QObject * parent)
     :QObject(parent), d_ptr(new ModemMonitorPrivate)
 {
-    Q_D(ModemMonitor);
-    d->dialog.clear();
-
     KSharedConfigPtr config = KSharedConfig::openConfig(QLatin1String("plasma-nm"));
     KConfigGroup grp(config, QLatin1String("General"));
 
@@ -65,13 +72,26 @@ ModemMonitor::ModemMonitor(QObject * parent)
             }
         }
     }
+
+    connect(ModemManager::notifier(), &ModemManager::Notifier::modemRemoved, this, &ModemMonitor::modemRemoved);
 }
 
 ModemMonitor::~ModemMonitor()
 {
+    Q_D(ModemMonitor);
+
+    Q_FOREACH (const QPointer<PinDialog> &dialog, d->dialogs) {
+        delete dialog.data();
+    }
     delete d_ptr;
 }
 
+bool ModemMonitor::isBusy() const
+{
+    Q_D(const ModemMonitor);
+    return !d->dialogs.isEmpty() || !d->silentUnlockPending.isEmpty();
+}
+
 void ModemMonitor::unlockModem(const QString &modemUni)
 {
     Q_D(ModemMonitor);
@@ -86,7 +106,7 @@ void ModemMonitor::unlockModem(const QString &modemUni)
 
     connect(modem.data(), &ModemManager::Modem::unlockRequiredChanged, this, &ModemMonitor::requestPin, Qt::UniqueConnection);
 
-    if (d->dialog || (modem && modem->unlockRequired() == MM_MODEM_LOCK_NONE) || (modem && modem->unlockRequired() == MM_MODEM_LOCK_UNKNOWN)) {
+    if (d->dialogs.contains(modemUni) || (modem && modem->unlockRequired() == MM_MODEM_LOCK_NONE) || (modem && modem->unlockRequired() == MM_MODEM_LOCK_UNKNOWN)) {
         return;
     }
 
@@ -97,6 +117,16 @@ void ModemMonitor::unlockModem(const QString &modemUni)
     }
 }
 
+void ModemMonitor::modemRemoved(const QString &modemUni)
+{
+    Q_D(ModemMonitor);
+
+    // The dialog closes itself when its modem disappears
+    d->silentUnlockTried.remove(modemUni);
+    d->silentUnlockPending.remove(modemUni);
+    checkIdle();
+}
+
 void ModemMonitor::requestPin(MMModemLock lock)
 {
     Q_D(ModemMonitor);
@@ -111,93 +141,243 @@ void ModemMonitor::requestPin(MMModemLock lock)
         return;
     }
 
-    if (d->dialog) {
-        qCDebug(PLASMA_NM) << "PinDialog already running";
+    if (d->dialogs.contains(modem->uni()) || d->silentUnlockPending.contains(modem->uni())) {
+        qCDebug(PLASMA_NM) << "Modem" << modem->uni() << "is already being unlocked";
         return;
     }
 
+    if (lock == MM_MODEM_LOCK_SIM_PIN && !d->silentUnlockTried.contains(modem->uni()) && unlockWithStoredPin(modem)) {
+        return;
+    }
+
+    showPinDialog(modem, lock);
+}
+
+bool ModemMonitor::unlockWithStoredPin(ModemManager::Modem *modem)
+{
+    Q_D(ModemMonitor);
+
+    d->silentUnlockTried.insert(modem->uni());
+
+    // Unknown retries are reported as 0, don't risk anything then
+    if (modem->unlockRetries().value(MM_MODEM_LOCK_SIM_PIN, 0) < SILENT_UNLOCK_MIN_RETRIES) {
+        return false;
+    }
+
+    // Only use the PIN of a connection which clearly belongs to this modem
+    NetworkManager::Connection::Ptr matchingConnection;
+    QList<NetworkManager::Connection::Ptr> candidates;
+    Q_FOREACH (const NetworkManager::Connection::Ptr &connection, NetworkManager::listConnections()) {
+        NetworkManager::ConnectionSettings::Ptr settings = connection->settings();
+        if (settings->connectionType() != NetworkManager::ConnectionSettings::Gsm) {
+            continue;
+        }
+
+        NetworkManager::GsmSetting::Ptr gsmSetting = settings->setting(NetworkManager::Setting::Gsm).staticCast<NetworkManager::GsmSetting>();
+        if (!gsmSetting || gsmSetting->pinFlags().testFlag(NetworkManager::Setting::NotSaved) ||
+            gsmSetting->pinFlags().testFlag(NetworkManager::Setting::NotRequired)) {
+            continue;
+        }
+
+        if (!settings->interfaceName().isEmpty() && settings->interfaceName() == modem->primaryPort()) {
+            matchingConnection = connection;
+            break;
+        } else if (settings->interfaceName().isEmpty()) {
+            candidates << connection;
+        }
+    }
+
+    // A connection not bound to an interface could be meant for any modem, sending its PIN
+    // to the wrong SIM would waste an attempt, so guess only when there is a single modem
+    if (!matchingConnection && candidates.size() == 1 && ModemManager::modemDevices().size() == 1) {
+        matchingConnection = candidates.first();
+    }
+
+    if (!matchingConnection) {
+        return false;
+    }
+
+    qCDebug(PLASMA_NM) << "Trying stored PIN of" << matchingConnection->name() << "for" << modem->uni();
+    d->silentUnlockPending.insert(modem->uni());
+    QDBusPendingReply<NMVariantMapMap> reply = matchingConnection->secrets(QLatin1String("gsm"));
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
+    watcher->setProperty("modemUni", modem->uni());
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &ModemMonitor::onStoredPinArrived);
+    return true;
+}
+
+void ModemMonitor::onStoredPinArrived(QDBusPendingCallWatcher *watcher)
+{
+    Q_D(ModemMonitor);
+
+    QDBusPendingReply<NMVariantMapMap> reply = *watcher;
+    const QString modemUni = watcher->property("modemUni").toString();
+    watcher->deleteLater();
+
+    if (!d->silentUnlockPending.contains(modemUni)) {
+        return;
+    }
+
+    QString pin;
+    if (reply.isValid()) {
+        pin = reply.value().value(QLatin1String("gsm")).value(QLatin1String("pin")).toString();
+    }
+
+    ModemManager::ModemDevice::Ptr modemDevice = ModemManager::findModemDevice(modemUni);
+    if (pin.isEmpty() || !modemDevice || !modemDevice->sim()) {
+        silentUnlockFailed(modemUni);
+        return;
+    }
+
+    QDBusPendingCallWatcher *pinWatcher = new QDBusPendingCallWatcher(modemDevice->sim()->sendPin(pin), this);
+    pinWatcher->setProperty("modemUni", modemUni);
+    pinWatcher->setProperty("silent", true);
+    connect(pinWatcher, &QDBusPendingCallWatcher::finished, this, &ModemMonitor::onSendPinArrived);
+}
+
+void ModemMonitor::silentUnlockFailed(const QString &modemUni)
+{
+    Q_D(ModemMonitor);
+
+    d->silentUnlockPending.remove(modemUni);
+
+    // Fall back to asking the user
+    ModemManager::ModemDevice::Ptr modemDevice = ModemManager::findModemDevice(modemUni);
+    if (modemDevice) {
+        ModemManager::Modem::Ptr modem = modemDevice->interface(ModemManager::ModemDevice::ModemInterface).objectCast<ModemManager::Modem>();
+        if (modem) {
+            showPinDialog(modem.data(), modem->unlockRequired());
+        }
+    }
+    checkIdle();
+}
+
+void ModemMonitor::checkIdle()
+{
+    if (!isBusy()) {
+        Q_EMIT idle();
+    }
+}
+
+void ModemMonitor::showPinDialog(ModemManager::Modem *modem, MMModemLock lock)
+{
+    Q_D(ModemMonitor);
+
+    PinDialog *dialog = 0;
     if (lock == MM_MODEM_LOCK_SIM_PIN) {
-        d->dialog = new PinDialog(modem, PinDialog::SimPin);
+        dialog = new PinDialog(modem, PinDialog::SimPin);
     } else if (lock == MM_MODEM_LOCK_SIM_PIN2) {
-        d->dialog = new PinDialog(modem, PinDialog::SimPin2);
+        dialog = new PinDialog(modem, PinDialog::SimPin2);
     } else if (lock == MM_MODEM_LOCK_SIM_PUK) {
-        d->dialog = new PinDialog(modem, PinDialog::SimPuk);
+        dialog = new PinDialog(modem, PinDialog::SimPuk);
     } else if (lock == MM_MODEM_LOCK_SIM_PUK2 ) {
-        d->dialog = new PinDialog(modem, PinDialog::SimPuk);
+        dialog = new PinDialog(modem, PinDialog::SimPuk);
     } else if (lock == MM_MODEM_LOCK_PH_SP_PIN) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemServiceProviderPin);
+        dialog = new PinDialog(modem, PinDialog::ModemServiceProviderPin);
     } else if (lock == MM_MODEM_LOCK_PH_SP_PUK) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemServiceProviderPuk);
+        dialog = new PinDialog(modem, PinDialog::ModemServiceProviderPuk);
     } else if (lock == MM_MODEM_LOCK_PH_NET_PIN) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemNetworkPin);
+        dialog = new PinDialog(modem, PinDialog::ModemNetworkPin);
     } else if (lock == MM_MODEM_LOCK_PH_NET_PUK) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemNetworkPuk);
+        dialog = new PinDialog(modem, PinDialog::ModemNetworkPuk);
     } else if (lock == MM_MODEM_LOCK_PH_SIM_PIN) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemPin);
+        dialog = new PinDialog(modem, PinDialog::ModemPin);
     } else if (lock == MM_MODEM_LOCK_PH_CORP_PIN) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemCorporatePin);
+        dialog = new PinDialog(modem, PinDialog::ModemCorporatePin);
     } else if (lock == MM_MODEM_LOCK_PH_CORP_PUK) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemCorporatePuk);
+        dialog = new PinDialog(modem, PinDialog::ModemCorporatePuk);
     } else if (lock == MM_MODEM_LOCK_PH_FSIM_PIN) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemPhFsimPin);
+        dialog = new PinDialog(modem, PinDialog::ModemPhFsimPin);
     } else if (lock == MM_MODEM_LOCK_PH_FSIM_PUK) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemPhFsimPuk);
+        dialog = new PinDialog(modem, PinDialog::ModemPhFsimPuk);
     } else if (lock == MM_MODEM_LOCK_PH_NETSUB_PIN) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemNetworkSubsetPin);
+        dialog = new PinDialog(modem, PinDialog::ModemNetworkSubsetPin);
     } else if (lock == MM_MODEM_LOCK_PH_NETSUB_PUK) {
-        d->dialog = new PinDialog(modem, PinDialog::ModemNetworkSubsetPuk);
+        dialog = new PinDialog(modem, PinDialog::ModemNetworkSubsetPuk);
     }
 
-    if (d->dialog.data()->exec() != QDialog::Accepted) {
-        goto OUT;
+    if (!dialog) {
+        return;
     }
 
-    qCDebug(PLASMA_NM) << "Sending unlock code";
+    // Not modal, other modems can be unlocked while this dialog is shown
+    dialog->setProperty("modemUni", modem->uni());
+    d->dialogs.insert(modem->uni(), dialog);
+    connect(dialog, &QDialog::finished, this, &ModemMonitor::onPinDialogFinished);
+    dialog->show();
+}
 
-    {
-        ModemManager::Sim::Ptr sim;
-        ModemManager::ModemDevice::Ptr modemDevice = ModemManager::findModemDevice(modem->uni());
-        if (modemDevice && modemDevice->sim()) {
-            sim = modemDevice->sim();
-        }
+void ModemMonitor::onPinDialogFinished(int result)
+{
+    Q_D(ModemMonitor);
 
-        if (!sim) {
-            return;
-        }
+    PinDialog *dialog = qobject_cast<PinDialog*>(sender());
+    if (!dialog) {
+        return;
+    }
 
-        QDBusPendingCallWatcher *watcher = 0;
-
-        PinDialog::Type type = d->dialog.data()->type();
-
-        if (type == PinDialog::SimPin || type == PinDialog::SimPin2 ||
-            type == PinDialog::ModemServiceProviderPin || type == PinDialog::ModemNetworkPin ||
-            type == PinDialog::ModemPin || type == PinDialog::ModemCorporatePin ||
-            type == PinDialog::ModemPhFsimPin || type == PinDialog::ModemNetworkSubsetPin) {
-            QDBusPendingCall reply = sim->sendPin(d->dialog.data()->pin());
-            watcher = new QDBusPendingCallWatcher(reply, sim.data());
-        } else if (type == PinDialog::SimPuk ||
-            type == PinDialog::SimPuk2 || type == PinDialog::ModemServiceProviderPuk ||
-            type == PinDialog::ModemNetworkPuk || type == PinDialog::ModemCorporatePuk ||
-            type == PinDialog::ModemPhFsimPuk || type == PinDialog::ModemNetworkSubsetPuk) {
-            QDBusPendingCall reply = sim->sendPuk(d->dialog.data()->puk(), d->dialog.data()->pin());
-            watcher = new QDBusPendingCallWatcher(reply, sim.data());
-        }
+    const QString modemUni = dialog->property("modemUni").toString();
+    d->dialogs.remove(modemUni);
+    dialog->deleteLater();
+    checkIdle();
 
-        connect(watcher, &QDBusPendingCallWatcher::finished, this, &ModemMonitor::onSendPinArrived);
+    if (result != QDialog::Accepted) {
+        return;
     }
 
-OUT:
-    if(d->dialog) {
-        d->dialog.data()->deleteLater();
+    qCDebug(PLASMA_NM) << "Sending unlock code";
+
+    ModemManager::Sim::Ptr sim;
+    ModemManager::ModemDevice::Ptr modemDevice = ModemManager::findModemDevice(modemUni);
+    if (modemDevice && modemDevice->sim()) {
+        sim = modemDevice->sim();
+    }
+
+    if (!sim) {
+        return;
+    }
+
+    QDBusPendingCallWatcher *watcher = 0;
+
+    PinDialog::Type type = dialog->type();
+
+    if (type == PinDialog::SimPin || type == PinDialog::SimPin2 ||
+        type == PinDialog::ModemServiceProviderPin || type == PinDialog::ModemNetworkPin ||
+        type == PinDialog::ModemPin || type == PinDialog::ModemCorporatePin ||
+        type == PinDialog::ModemPhFsimPin || type == PinDialog::ModemNetworkSubsetPin) {
+        QDBusPendingCall reply = sim->sendPin(dialog->pin());
+        watcher = new QDBusPendingCallWatcher(reply, sim.data());
+    } else if (type == PinDialog::SimPuk ||
+        type == PinDialog::SimPuk2 || type == PinDialog::ModemServiceProviderPuk ||
+        type == PinDialog::ModemNetworkPuk || type == PinDialog::ModemCorporatePuk ||
+        type == PinDialog::ModemPhFsimPuk || type == PinDialog::ModemNetworkSubsetPuk) {
+        QDBusPendingCall reply = sim->sendPuk(dialog->puk(), dialog->pin());
+        watcher = new QDBusPendingCallWatcher(reply, sim.data());
+    }
+
+    if (watcher) {
+        watcher->setProperty("modemUni", modemUni);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, &ModemMonitor::onSendPinArrived);
     }
-    d->dialog.clear();
 }
 
 void ModemMonitor::onSendPinArrived(QDBusPendingCallWatcher * watcher)
 {
-    QDBusPendingReply<> reply = *watcher;
+    Q_D(ModemMonitor);
 
-    if (reply.isValid()) {
+    QDBusPendingReply<> reply = *watcher;
+    const QString modemUni = watcher->property("modemUni").toString();
+
+    if (watcher->property("silent").toBool()) {
+        if (reply.isValid()) {
+            qCDebug(PLASMA_NM) << "Modem" << modemUni << "unlocked with stored PIN";
+            d->silentUnlockPending.remove(modemUni);
+            checkIdle();
+        } else {
+            qCDebug(PLASMA_NM) << "Stored PIN was refused for" << modemUni << reply.error().message();
+            silentUnlockFailed(modemUni);
+        }
+    } else if (reply.isValid()) {
         // Automatically enabling this for cell phones with expensive data plans is not a good idea.
         //NetworkManager::setWwanEnabled(true);
     } else {
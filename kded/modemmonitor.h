@@ -42,12 +42,34 @@ public:
     explicit ModemMonitor(QObject * parent);
     virtual ~ModemMonitor();
 
+    /**
+     * @return true while a modem is being unlocked
+     */
+    bool isBusy() const;
+
 public Q_SLOTS:
     void unlockModem(const QString &modemUni);
+Q_SIGNALS:
+    /**
+     * Emitted when the last PIN dialog is closed or the last stored PIN was sent
+     */
+    void idle();
 private Q_SLOTS:
     void requestPin(MMModemLock lock);
+    void modemRemoved(const QString &modemUni);
+    void onStoredPinArrived(QDBusPendingCallWatcher *watcher);
+    void onPinDialogFinished(int result);
     void onSendPinArrived(QDBusPendingCallWatcher *);
 private:
+    /**
+     * @brief unlockWithStoredPin sends the PIN stored in the GSM connection of the modem
+     * @return false if there is no stored PIN which can be used safely
+     */
+    bool unlockWithStoredPin(ModemManager::Modem *modem);
+    void silentUnlockFailed(const QString &modemUni);
+    void checkIdle();
+    void showPinDialog(ModemManager::Modem *modem, MMModemLock lock);
+
     ModemMonitorPrivate * d_ptr;
 };
 
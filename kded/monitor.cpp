@@ -22,14 +22,31 @@
 #include "monitor.h"
 
 #include <QDBusConnection>
+#include <QDBusServiceWatcher>
+
+#if WITH_MODEMMANAGER_SUPPORT
+#include <ModemManagerQt/Manager>
+#endif
 
 Monitor::Monitor(QObject* parent)
     : QObject(parent)
+    , m_bluetoothMonitor(0)
+#if WITH_MODEMMANAGER_SUPPORT
+    , m_modemMonitor(0)
+#endif
 {
 #if WITH_MODEMMANAGER_SUPPORT
-    m_modemMonitor = new ModemMonitor(this);
+    connect(ModemManager::notifier(), &ModemManager::Notifier::modemAdded, this, &Monitor::modemAdded);
+    connect(ModemManager::notifier(), &ModemManager::Notifier::modemRemoved, this, &Monitor::releaseModemMonitor);
+    if (!ModemManager::modemDevices().isEmpty()) {
+        modemMonitor();
+    }
 #endif
-    m_bluetoothMonitor = new BluetoothMonitor(this);
+
+    // Bluetooth connections are only added or looked up while BlueZ is running
+    QDBusServiceWatcher *bluezWatcher = new QDBusServiceWatcher(QStringLiteral("org.bluez"), QDBusConnection::systemBus(),
+                                                                QDBusServiceWatcher::WatchForUnregistration, this);
+    connect(bluezWatcher, &QDBusServiceWatcher::serviceUnregistered, this, &Monitor::bluetoothServiceUnregistered);
 
     QDBusConnection::sessionBus().registerService("org.kde.plasmanetworkmanagement");
     QDBusConnection::sessionBus().registerObject("/org/kde/plasmanetworkmanagement", this, QDBusConnection::ExportScriptableContents);
@@ -45,18 +62,59 @@ Monitor::~Monitor()
 
 bool Monitor::bluetoothConnectionExists(const QString &bdAddr, const QString &service)
 {
-    return m_bluetoothMonitor->bluetoothConnectionExists(bdAddr, service);
+    return bluetoothMonitor()->bluetoothConnectionExists(bdAddr, service);
 }
 
 void Monitor::addBluetoothConnection(const QString &bdAddr, const QString &service, const QString &connectionName)
 {
-    m_bluetoothMonitor->addBluetoothConnection(bdAddr, service, connectionName);
+    bluetoothMonitor()->addBluetoothConnection(bdAddr, service, connectionName);
 }
 
 #if WITH_MODEMMANAGER_SUPPORT
 void Monitor::unlockModem(const QString& modem)
 {
     qDebug() << "unlocking " << modem;
-    m_modemMonitor->unlockModem(modem);
+    modemMonitor()->unlockModem(modem);
+}
+
+void Monitor::modemAdded()
+{
+    // A new monitor unlocks all present modems itself, an existing one watches modemAdded too
+    modemMonitor();
+}
+
+void Monitor::releaseModemMonitor()
+{
+    if (m_modemMonitor && !m_modemMonitor->isBusy() && ModemManager::modemDevices().isEmpty()) {
+        m_modemMonitor->deleteLater();
+        m_modemMonitor = 0;
+    }
+}
+
+ModemMonitor *Monitor::modemMonitor()
+{
+    if (!m_modemMonitor) {
+        m_modemMonitor = new ModemMonitor(this);
+        // Modems removed while a dialog was shown are only released once it's closed
+        connect(m_modemMonitor, &ModemMonitor::idle, this, &Monitor::releaseModemMonitor);
+    }
+    return m_modemMonitor;
 }
 #endif
+
+void Monitor::bluetoothServiceUnregistered()
+{
+    // A wizard which is still shown doesn't need the monitor anymore
+    if (m_bluetoothMonitor) {
+        m_bluetoothMonitor->deleteLater();
+        m_bluetoothMonitor = 0;
+    }
+}
+
+BluetoothMonitor *Monitor::bluetoothMonitor()
+{
+    if (!m_bluetoothMonitor) {
+        m_bluetoothMonitor = new BluetoothMonitor(this);
+    }
+    return m_bluetoothMonitor;
+}
@@ -42,10 +42,21 @@ public Q_SLOTS:
     Q_SCRIPTABLE void addBluetoothConnection(const QString &bdAddr, const QString &service, const QString &connectionName);
 #if WITH_MODEMMANAGER_SUPPORT
     Q_SCRIPTABLE void unlockModem(const QString &modem);
+
+private Q_SLOTS:
+    void modemAdded();
+    // Deletes the modem monitor once no modem is left and no modem is being unlocked
+    void releaseModemMonitor();
 #endif
+private Q_SLOTS:
+    void bluetoothServiceUnregistered();
 private:
+    // Sub-monitors are created on first use, the modem monitor is deleted again once
+    // the last modem is gone and the Bluetooth monitor once BlueZ goes away
+    BluetoothMonitor *bluetoothMonitor();
     BluetoothMonitor * m_bluetoothMonitor;
 #if WITH_MODEMMANAGER_SUPPORT
+    ModemMonitor *modemMonitor();
     ModemMonitor * m_modemMonitor;
 #endif
 };
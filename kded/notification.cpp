@@ -27,18 +27,32 @@
 #include <uiutils.h>
 
 #include <NetworkManagerQt/Manager>
+#include <NetworkManagerQt/Settings>
+#include <NetworkManagerQt/WirelessDevice>
+#include <NetworkManagerQt/WirelessSetting>
 
 #include <KLocalizedString>
 #include <KNotification>
-#include <KIconLoader>
 
 #include <QDBusConnection>
-#include <QIcon>
 #include <QTimer>
 
+// Number of notifications per device or connection which can be shown at once
+#define NOTIFICATION_BURST 3
+// Time to get another notification allowed
+#define NOTIFICATION_REFILL_INTERVAL 20000
+// Failures within this time are merged into one notification
+#define NOTIFICATION_FAILURE_WINDOW 60000
+// Minimal time between two updates of the same notification
+#define NOTIFICATION_QUIET_PERIOD 2000
+
 Notification::Notification(QObject *parent) :
     QObject(parent)
+    , m_flushTimer(new QTimer(this))
 {
+    m_flushTimer->setInterval(NOTIFICATION_QUIET_PERIOD);
+    connect(m_flushTimer, &QTimer::timeout, this, &Notification::flushNotifications);
+
     // devices
     Q_FOREACH (const NetworkManager::Device::Ptr &device, NetworkManager::networkInterfaces()) {
         addDevice(device);
@@ -77,10 +91,17 @@ void Notification::stateChanged(NetworkManager::Device::State newstate, NetworkM
     Q_UNUSED(oldstate)
 
     NetworkManager::Device *device = qobject_cast<NetworkManager::Device*>(sender());
-    if (newstate == NetworkManager::Device::Activated && m_notifications.contains(device->uni())) {
-        KNotification *notify = m_notifications.value(device->uni());
-        notify->deleteLater();
-        m_notifications.remove(device->uni());
+    if (m_resumingConnections.contains(device->uni())) {
+        resumeConnection(NetworkManager::findNetworkInterface(device->uni()));
+    }
+
+    if (newstate == NetworkManager::Device::Activated) {
+        discardPendingNotification(device->uni());
+        if (m_notifications.contains(device->uni())) {
+            KNotification *notify = m_notifications.value(device->uni());
+            notify->deleteLater();
+            m_notifications.remove(device->uni());
+        }
         return;
     } else if (newstate != NetworkManager::Device::Failed) {
         return;
@@ -331,23 +352,7 @@ void Notification::stateChanged(NetworkManager::Device::State newstate, NetworkM
         return;
     }
 
-    if (m_notifications.contains(device->uni())) {
-        KNotification *notify = m_notifications.value(device->uni());
-        notify->setText(text);
-        notify->update();
-    } else {
-        KNotification *notify = new KNotification(QStringLiteral("DeviceFailed"), KNotification::CloseOnTimeout, this);
-        connect(notify, &KNotification::closed, this, &Notification::notificationClosed);
-        notify->setProperty("uni", device->uni());
-        notify->setComponentName(QStringLiteral("networkmanagement"));
-        notify->setPixmap(QIcon::fromTheme(QStringLiteral("dialog-warning")).pixmap(KIconLoader::SizeHuge));
-        notify->setTitle(identifier);
-        notify->setText(text);
-        notify->sendEvent();
-        if (notify->id() != -1) {
-                m_notifications[device->uni()] = notify;
-        }
-    }
+    showNotification(device->uni(), QStringLiteral("DeviceFailed"), identifier, text, QStringLiteral("dialog-warning"), true);
 }
 
 void Notification::addActiveConnection(const QString &path)
@@ -392,9 +397,13 @@ void Notification::onActiveConnectionStateChanged(NetworkManager::ActiveConnecti
 
     QString eventId, text, iconName;
     const QString acName = ac->id();
-    const QString connectionId = ac->path();
+    // Keyed by uuid, every activation attempt gets a new active connection path
+    const QString connectionId = ac->uuid();
 
     if (state == NetworkManager::ActiveConnection::Activated) {
+        discardPendingNotification(connectionId);
+        discardPendingNotification(QStringLiteral("offlineNotification"));
+
         auto foundConnection = std::find_if(m_activeConnectionsBeforeSleep.constBegin(),
                                             m_activeConnectionsBeforeSleep.constEnd(),
                                             [ac](const QString &uuid) {
@@ -443,25 +452,15 @@ void Notification::onActiveConnectionStateChanged(NetworkManager::ActiveConnecti
         return;
     }
 
-    KNotification *notify = new KNotification(eventId, KNotification::CloseOnTimeout, this);
-    connect(notify, &KNotification::closed, this, &Notification::notificationClosed);
-    notify->setProperty("uni", connectionId);
-    notify->setComponentName(QStringLiteral("networkmanagement"));
-    if (!iconName.isEmpty()) {
-        notify->setIconName(iconName);
-    } else {
+    if (iconName.isEmpty()) {
         if (state == NetworkManager::ActiveConnection::Activated) {
-            notify->setIconName(QStringLiteral("dialog-information"));
+            iconName = QStringLiteral("dialog-information");
         } else {
-            notify->setIconName(QStringLiteral("dialog-warning"));
+            iconName = QStringLiteral("dialog-warning");
         }
     }
-    notify->setTitle(acName);
-    notify->setText(text);
-    notify->sendEvent();
-    if (notify->id() != -1) {
-        m_notifications[connectionId] = notify;
-    }
+
+    showNotification(connectionId, eventId, acName, text, iconName, state != NetworkManager::ActiveConnection::Activated);
 }
 
 void Notification::onVpnConnectionStateChanged(NetworkManager::VpnConnection::State state, NetworkManager::VpnConnection::StateChangeReason reason)
@@ -470,9 +469,10 @@ void Notification::onVpnConnectionStateChanged(NetworkManager::VpnConnection::St
 
     QString eventId, text;
     const QString vpnName = vpn->connection()->name();
-    const QString connectionId = vpn->path();
+    const QString connectionId = vpn->uuid();
 
     if (state == NetworkManager::VpnConnection::Activated) {
+        discardPendingNotification(connectionId);
         eventId = QStringLiteral("ConnectionActivated");
         text = i18n("VPN connection '%1' activated.", vpnName);
     } else if (state == NetworkManager::VpnConnection::Failed) {
@@ -523,27 +523,19 @@ void Notification::onVpnConnectionStateChanged(NetworkManager::VpnConnection::St
         break;
     }
 
-    KNotification *notify = new KNotification(eventId, KNotification::CloseOnTimeout, this);
-    connect(notify, &KNotification::closed, this, &Notification::notificationClosed);
-    notify->setProperty("uni", connectionId);
-    notify->setComponentName("networkmanagement");
-    if (state == NetworkManager::VpnConnection::Activated) {
-        notify->setIconName(QStringLiteral("dialog-information"));
-    } else {
-        notify->setIconName(QStringLiteral("dialog-warning"));
-    }
-    notify->setTitle(vpnName);
-    notify->setText(text);
-    notify->sendEvent();
-    if (notify->id() != -1) {
-        m_notifications[connectionId] = notify;
-    }
+    const bool activated = state == NetworkManager::VpnConnection::Activated;
+    showNotification(connectionId, eventId, vpnName, text,
+                     activated ? QStringLiteral("dialog-information") : QStringLiteral("dialog-warning"), !activated);
 }
 
 void Notification::notificationClosed()
 {
     KNotification *notify = qobject_cast<KNotification*>(sender());
-    m_notifications.remove(notify->property("uni").toString());
+    const QString uni = notify->property("uni").toString();
+    // It might have been replaced by a newer notification already
+    if (m_notifications.value(uni) == notify) {
+        m_notifications.remove(uni);
+    }
     notify->deleteLater();
 }
 
@@ -559,13 +551,20 @@ void Notification::onPrepareForSleep(bool sleep)
         // store all active notifications so we don't show a "is connected" notification
         // on resume if we were connected previously
         m_activeConnectionsBeforeSleep.clear();
+        m_devicesBeforeSleep.clear();
+        m_resumingConnections.clear();
         const auto &connections = NetworkManager::activeConnections();
         for (const auto &connection : connections) {
             if (!connection->vpn() && connection->state() == NetworkManager::ActiveConnection::State::Activated) {
                 m_activeConnectionsBeforeSleep << connection->uuid();
+                if (!connection->devices().isEmpty()) {
+                    m_devicesBeforeSleep.insert(connection->uuid(), connection->devices().first());
+                }
             }
         }
     } else {
+        resumeConnections();
+
         if (!m_checkActiveConnectionOnResumeTimer) {
             m_checkActiveConnectionOnResumeTimer = new QTimer(this);
             m_checkActiveConnectionOnResumeTimer->setInterval(10000);
@@ -585,6 +584,9 @@ void Notification::onCheckActiveConnectionOnResume()
     }
 
     m_activeConnectionsBeforeSleep.clear();
+    // Whatever wasn't resumed until now is left to autoconnect of NetworkManager
+    m_devicesBeforeSleep.clear();
+    m_resumingConnections.clear();
 
     const auto &connections = NetworkManager::activeConnections();
     for (const auto &connection : connections) {
@@ -595,16 +597,217 @@ void Notification::onCheckActiveConnectionOnResume()
         }
     }
 
-    KNotification *notify = new KNotification(QStringLiteral("NoLongerConnected"), KNotification::CloseOnTimeout, this);
-    connect(notify, &KNotification::closed, this, &Notification::notificationClosed);
-    const QString uni = QStringLiteral("offlineNotification");
-    notify->setProperty("uni", uni);
-    notify->setComponentName("networkmanagement");
-    notify->setIconName(QStringLiteral("dialog-warning"));
-    notify->setTitle(i18n("No Network Connection"));
-    notify->setText(i18n("You are no longer connected to a network."));
-    notify->sendEvent();
-    if (notify->id() != -1) {
-        m_notifications[uni] = notify;
+    showNotification(QStringLiteral("offlineNotification"), QStringLiteral("NoLongerConnected"), i18n("No Network Connection"),
+                     i18n("You are no longer connected to a network."), QStringLiteral("dialog-warning"), false);
+}
+
+void Notification::onResumeNetworkAppeared(const QString &ssid)
+{
+    Q_UNUSED(ssid)
+
+    NetworkManager::Device *device = qobject_cast<NetworkManager::Device*>(sender());
+    if (m_resumingConnections.contains(device->uni())) {
+        resumeConnection(NetworkManager::findNetworkInterface(device->uni()));
+    }
+}
+
+void Notification::resumeConnections()
+{
+    QHash<QString, QList<QByteArray> > ssids;
+
+    QHash<QString, QString>::const_iterator it = m_devicesBeforeSleep.constBegin();
+    for (; it != m_devicesBeforeSleep.constEnd(); ++it) {
+        NetworkManager::Connection::Ptr connection = NetworkManager::findConnectionByUuid(it.key());
+        NetworkManager::Device::Ptr device = NetworkManager::findNetworkInterface(it.value());
+        if (!connection || !device || m_resumingConnections.contains(device->uni())) {
+            continue;
+        }
+
+        if (device->type() == NetworkManager::Device::Wifi) {
+            NetworkManager::WirelessSetting::Ptr wirelessSetting = connection->settings()->setting(NetworkManager::Setting::Wireless).staticCast<NetworkManager::WirelessSetting>();
+            if (!wirelessSetting) {
+                continue;
+            }
+            ssids[device->uni()] << wirelessSetting->ssid();
+            NetworkManager::WirelessDevice::Ptr wifiDevice = device.objectCast<NetworkManager::WirelessDevice>();
+            connect(wifiDevice.data(), &NetworkManager::WirelessDevice::networkAppeared, this, &Notification::onResumeNetworkAppeared, Qt::UniqueConnection);
+        }
+
+        m_resumingConnections.insert(device->uni(), it.key());
+    }
+
+    // Scan only for the networks we were connected to, this is much faster than a full scan
+    QHash<QString, QList<QByteArray> >::const_iterator ssidIt = ssids.constBegin();
+    for (; ssidIt != ssids.constEnd(); ++ssidIt) {
+        NetworkManager::WirelessDevice::Ptr wifiDevice = NetworkManager::findNetworkInterface(ssidIt.key()).objectCast<NetworkManager::WirelessDevice>();
+        if (wifiDevice) {
+            QVariantMap options;
+            options.insert(QStringLiteral("ssids"), QVariant::fromValue(ssidIt.value()));
+            wifiDevice->requestScan(options);
+        }
+    }
+
+    // Devices which are already available get their connection right away, others once they are
+    Q_FOREACH (const QString &uni, m_resumingConnections.keys()) {
+        resumeConnection(NetworkManager::findNetworkInterface(uni));
+    }
+}
+
+void Notification::resumeConnection(const NetworkManager::Device::Ptr &device)
+{
+    if (!device) {
+        return;
+    }
+
+    const QString uuid = m_resumingConnections.value(device->uni());
+    if (device->state() > NetworkManager::Device::Disconnected) {
+        // NetworkManager was faster or the user picked something else
+        m_resumingConnections.remove(device->uni());
+        return;
+    } else if (device->state() < NetworkManager::Device::Disconnected) {
+        // Still waking up
+        return;
+    }
+
+    NetworkManager::Connection::Ptr connection = NetworkManager::findConnectionByUuid(uuid);
+    if (!connection) {
+        m_resumingConnections.remove(device->uni());
+        return;
+    }
+
+    if (device->type() == NetworkManager::Device::Wifi) {
+        NetworkManager::WirelessSetting::Ptr wirelessSetting = connection->settings()->setting(NetworkManager::Setting::Wireless).staticCast<NetworkManager::WirelessSetting>();
+        NetworkManager::WirelessDevice::Ptr wifiDevice = device.objectCast<NetworkManager::WirelessDevice>();
+        // Wait for the network to show up in the scan results, activating it before would fail
+        if (!wirelessSetting || !wifiDevice || !wifiDevice->findNetwork(QString::fromUtf8(wirelessSetting->ssid()))) {
+            return;
+        }
+    }
+
+    m_resumingConnections.remove(device->uni());
+    qCDebug(PLASMA_NM) << "Resuming connection" << connection->name() << "on" << device->interfaceName();
+    NetworkManager::activateConnection(connection->path(), device->uni(), QString());
+}
+
+void Notification::showNotification(const QString &uni, const QString &eventId, const QString &title, const QString &text, const QString &iconName, bool failure)
+{
+    if (!m_clock.isValid()) {
+        m_clock.start();
+    }
+    const qint64 now = m_clock.elapsed();
+
+    if (!m_buckets.contains(uni)) {
+        NotificationBucket bucket;
+        bucket.tokens = NOTIFICATION_BURST;
+        bucket.lastRefill = now;
+        bucket.lastShown = now - NOTIFICATION_QUIET_PERIOD;
+        m_buckets.insert(uni, bucket);
+    }
+
+    NotificationBucket &bucket = m_buckets[uni];
+    bucket.eventId = eventId;
+    bucket.title = title;
+    bucket.text = text;
+    bucket.iconName = iconName;
+    bucket.pending = true;
+
+    if (failure) {
+        bucket.failures << now;
+    }
+
+    if (!showPendingNotification(uni, bucket, now) && !m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+bool Notification::showPendingNotification(const QString &uni, NotificationBucket &bucket, qint64 now)
+{
+    while (!bucket.failures.isEmpty() && now - bucket.failures.first() > NOTIFICATION_FAILURE_WINDOW) {
+        bucket.failures.removeFirst();
+    }
+
+    const int refill = (now - bucket.lastRefill) / NOTIFICATION_REFILL_INTERVAL;
+    if (refill > 0) {
+        bucket.tokens = qMin(bucket.tokens + refill, NOTIFICATION_BURST);
+        bucket.lastRefill += refill * NOTIFICATION_REFILL_INTERVAL;
+    }
+
+    if (!bucket.pending) {
+        return true;
+    }
+
+    if (now - bucket.lastShown < NOTIFICATION_QUIET_PERIOD) {
+        return false;
+    }
+
+    QString text = bucket.text;
+    if (bucket.failures.size() > 1) {
+        text = i18np("%2\n%1 failure in the last minute", "%2\n%1 failures in the last minute", bucket.failures.size(), text);
+    }
+
+    KNotification *notify = m_notifications.value(uni);
+    if (notify && notify->eventId() == bucket.eventId) {
+        // Reuse the notification which is still shown instead of creating another one
+        notify->setTitle(bucket.title);
+        notify->setText(text);
+        notify->setIconName(bucket.iconName);
+        notify->update();
+    } else {
+        if (bucket.tokens < 1) {
+            return false;
+        }
+        --bucket.tokens;
+
+        if (notify) {
+            m_notifications.remove(uni);
+            notify->close();
+        }
+
+        notify = new KNotification(bucket.eventId, KNotification::CloseOnTimeout, this);
+        connect(notify, &KNotification::closed, this, &Notification::notificationClosed);
+        notify->setProperty("uni", uni);
+        notify->setComponentName(QStringLiteral("networkmanagement"));
+        notify->setIconName(bucket.iconName);
+        notify->setTitle(bucket.title);
+        notify->setText(text);
+        notify->sendEvent();
+        if (notify->id() != -1) {
+            m_notifications[uni] = notify;
+        }
+    }
+
+    bucket.pending = false;
+    bucket.lastShown = now;
+    return true;
+}
+
+void Notification::discardPendingNotification(const QString &uni)
+{
+    QHash<QString, NotificationBucket>::iterator it = m_buckets.find(uni);
+    if (it != m_buckets.end()) {
+        it->pending = false;
+    }
+}
+
+void Notification::flushNotifications()
+{
+    const qint64 now = m_clock.elapsed();
+    bool pending = false;
+
+    QHash<QString, NotificationBucket>::iterator it = m_buckets.begin();
+    while (it != m_buckets.end()) {
+        if (!showPendingNotification(it.key(), it.value(), now)) {
+            pending = true;
+        } else if (it->failures.isEmpty() && it->tokens == NOTIFICATION_BURST &&
+                   now - it->lastShown > NOTIFICATION_QUIET_PERIOD) {
+            // Nothing left to limit for this device or connection
+            it = m_buckets.erase(it);
+            continue;
+        }
+        ++it;
+    }
+
+    if (!pending) {
+        m_flushTimer->stop();
     }
 }
@@ -24,6 +24,7 @@
 #ifndef PLASMA_NM_NOTIFICATION_H
 #define PLASMA_NM_NOTIFICATION_H
 
+#include <QElapsedTimer>
 #include <QObject>
 
 #include <NetworkManagerQt/Device>
@@ -52,12 +53,63 @@ private Q_SLOTS:
 
     void onPrepareForSleep(bool sleep);
     void onCheckActiveConnectionOnResume();
+    void onResumeNetworkAppeared(const QString &ssid);
+    void flushNotifications();
 
 private:
+    struct NotificationBucket {
+        int tokens = 0;
+        qint64 lastRefill = 0;
+        qint64 lastShown = 0;
+        // Times of failures within the last minute
+        QList<qint64> failures;
+        bool pending = false;
+        QString eventId;
+        QString title;
+        QString text;
+        QString iconName;
+    };
+
+    /**
+     * @brief showNotification shows or updates the notification of a device or connection,
+     * bursts of notifications are rate limited and repeated failures merged into one notification
+     * @param uni device uni or connection uuid the notification belongs to
+     * @param failure true if the event is a failure which should be counted
+     */
+    void showNotification(const QString &uni, const QString &eventId, const QString &title, const QString &text, const QString &iconName, bool failure);
+    /**
+     * @return false if the notification has to wait for the quiet period or rate limit
+     */
+    bool showPendingNotification(const QString &uni, NotificationBucket &bucket, qint64 now);
+    /**
+     * @brief discardPendingNotification drops a notification still held back by the rate limit,
+     * it would be outdated once the device or connection is activated
+     */
+    void discardPendingNotification(const QString &uni);
+
+    /**
+     * @brief resumeConnections reactivates connections which were active before sleep
+     * on their previous devices, without waiting for autoconnect of NetworkManager
+     */
+    void resumeConnections();
+    /**
+     * @brief resumeConnection activates the pending connection of the device once
+     * the device is available again and, for wireless, the network was found
+     * @param device device the connection was active on before sleep
+     */
+    void resumeConnection(const NetworkManager::Device::Ptr &device);
+
     QHash<QString, KNotification*> m_notifications;
+    QHash<QString, NotificationBucket> m_buckets;
+    QElapsedTimer m_clock;
+    QTimer *m_flushTimer;
 
     bool m_preparingForSleep = false;
     QStringList m_activeConnectionsBeforeSleep;
+    // Connection uuid -> device uni the connection was active on before sleep
+    QHash<QString, QString> m_devicesBeforeSleep;
+    // Device uni -> connection uuid still waiting to be resumed
+    QHash<QString, QString> m_resumingConnections;
     QTimer *m_checkActiveConnectionOnResumeTimer = nullptr;
 
 };
@@ -24,12 +24,12 @@
 #include "ui_passworddialog.h"
 #include "uiutils.h"
 
+#include <vpnpluginregistry.h>
 #include <vpnuiplugin.h>
 
 #include <NetworkManagerQt/WirelessSetting>
 #include <NetworkManagerQt/VpnSetting>
 
-#include <KServiceTypeTrader>
 #include <KLocalizedString>
 #include <KIconLoader>
 
@@ -107,10 +107,8 @@ void PasswordDialog::initializeUi()
             VpnUiPlugin *vpnUiPlugin;
             QString error;
             const QString serviceType = vpnSetting->serviceType();
-            vpnUiPlugin = KServiceTypeTrader::createInstanceFromQuery<VpnUiPlugin>(QLatin1String("PlasmaNetworkManagement/VpnUiPlugin"),
-                                                                                   QString::fromLatin1("[X-NetworkManager-Services]=='%1'").arg(serviceType),
-                                                                                   this, QVariantList(), &error);
-            if (vpnUiPlugin && error.isEmpty()) {
+            vpnUiPlugin = VpnPluginRegistry::self()->plugin(serviceType, &error);
+            if (vpnUiPlugin) {
                 const QString shortName = serviceType.section('.', -1);
                 m_vpnWidget = vpnUiPlugin->askUser(vpnSetting, this);
                 QVBoxLayout *layout = new QVBoxLayout();
@@ -24,18 +24,35 @@
 #include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
 #include <QDesktopServices>
+#include <QStandardPaths>
 
+#include <KConfigGroup>
 #include <KLocalizedString>
 #include <KNotification>
+#include <KSharedConfig>
 
+#include <NetworkManagerQt/AccessPoint>
 #include <NetworkManagerQt/ActiveConnection>
+#include <NetworkManagerQt/WirelessDevice>
+
+#include "debug.h"
+
+// Page opened to log in, can be overridden to test against a local server
+#define PORTAL_URL "http://networkcheck.kde.org"
+// Portals not seen for this many days are dropped from the cache
+#define PORTAL_CACHE_EXPIRATION 90
 
 PortalMonitor::PortalMonitor(QObject *parent)
     : QObject(parent)
 {
+    const QByteArray portalUrl = qgetenv("PLASMA_NM_PORTAL_URL");
+    m_portalUrl = QUrl(portalUrl.isEmpty() ? QStringLiteral(PORTAL_URL) : QString::fromUtf8(portalUrl));
+
+    loadCache();
     checkConnectivity();
 
     connect(NetworkManager::notifier(), &NetworkManager::Notifier::connectivityChanged, this, &PortalMonitor::connectivityChanged);
+    connect(NetworkManager::notifier(), &NetworkManager::Notifier::primaryConnectionChanged, this, &PortalMonitor::primaryConnectionChanged);
 }
 
 PortalMonitor::~PortalMonitor()
@@ -44,22 +61,43 @@ PortalMonitor::~PortalMonitor()
 
 void PortalMonitor::connectivityChanged(NetworkManager::Connectivity connectivity)
 {
+    NetworkManager::ActiveConnection::Ptr primaryConnection = NetworkManager::primaryConnection();
+
     if (connectivity == NetworkManager::Portal) {
-        NetworkManager::ActiveConnection::Ptr primaryConnection = NetworkManager::primaryConnection();
-        KNotification *notification = new KNotification(QStringLiteral("CaptivePortal"), KNotification::CloseOnTimeout, this);
-        notification->setActions(QStringList{i18n("Log in")});
-        notification->setComponentName(QStringLiteral("networkmanagement"));
-        if (primaryConnection) {
-            notification->setTitle(primaryConnection->id());
-        } else {
-            notification->setTitle(i18n("Network authentication"));
+        updateCache(primaryConnection, true);
+        showLoginNotification(primaryConnection);
+    } else if (connectivity == NetworkManager::Full) {
+        updateCache(primaryConnection, false);
+        // Ask again when the portal session expires
+        closeLoginNotification();
+    }
+}
+
+void PortalMonitor::primaryConnectionChanged(const QString &path)
+{
+    Q_UNUSED(path)
+
+    closeLoginNotification();
+
+    NetworkManager::ActiveConnection::Ptr primaryConnection = NetworkManager::primaryConnection();
+    if (!primaryConnection) {
+        return;
+    }
+
+    // Known portals we weren't logged in to get the login prompt right away, the check
+    // below confirms it or withdraws the prompt when the previous session is still valid
+    Q_FOREACH (const QString &key, cacheKeys(primaryConnection)) {
+        if (m_cache.contains(key)) {
+            const PortalState state = m_cache.value(key);
+            if (state.portal && !state.loggedIn) {
+                qCDebug(PLASMA_NM) << "Connection" << primaryConnection->id() << "is a known captive portal";
+                showLoginNotification(primaryConnection);
+            }
+            break;
         }
-        notification->setText(i18n("You need to log in to this network"));
-        notification->sendEvent();
-        connect(notification, &KNotification::action1Activated, this, [] () {
-            QDesktopServices::openUrl(QUrl("http://networkcheck.kde.org"));
-        });
     }
+
+    checkConnectivity();
 }
 
 void PortalMonitor::checkConnectivity()
@@ -74,3 +112,128 @@ void PortalMonitor::checkConnectivity()
         watcher->deleteLater();
     });
 }
+
+QStringList PortalMonitor::cacheKeys(const NetworkManager::ActiveConnection::Ptr &connection) const
+{
+    QStringList keys;
+
+    if (connection->type() == NetworkManager::ConnectionSettings::Wireless) {
+        Q_FOREACH (const QString &uni, connection->devices()) {
+            NetworkManager::WirelessDevice::Ptr wifiDevice = NetworkManager::findNetworkInterface(uni).objectCast<NetworkManager::WirelessDevice>();
+            if (wifiDevice && wifiDevice->activeAccessPoint()) {
+                // Not the SSID, unrelated networks share it
+                keys << QStringLiteral("bssid:") + wifiDevice->activeAccessPoint()->hardwareAddress();
+                break;
+            }
+        }
+    }
+
+    keys << QStringLiteral("uuid:") + connection->uuid();
+    return keys;
+}
+
+void PortalMonitor::updateCache(const NetworkManager::ActiveConnection::Ptr &connection, bool portal)
+{
+    if (!connection) {
+        return;
+    }
+
+    bool changed = false;
+    Q_FOREACH (const QString &key, cacheKeys(connection)) {
+        if (!portal && !m_cache.contains(key)) {
+            // Only remember networks which were portals at some point
+            continue;
+        }
+
+        PortalState &state = m_cache[key];
+        // Cached networks stay known portals, full connectivity only means the login went through
+        const bool loggedIn = !portal;
+        if (!state.portal || state.loggedIn != loggedIn) {
+            changed = true;
+        }
+        state.portal = true;
+        state.loggedIn = loggedIn;
+        state.lastSeen = QDateTime::currentDateTime();
+    }
+
+    if (changed) {
+        saveCache();
+    }
+}
+
+void PortalMonitor::showLoginNotification(const NetworkManager::ActiveConnection::Ptr &connection)
+{
+    const QString connectionPath = connection ? connection->path() : QString();
+    if (!connectionPath.isEmpty() && connectionPath == m_notifiedConnection) {
+        return;
+    }
+    closeLoginNotification();
+    m_notifiedConnection = connectionPath;
+
+    KNotification *notification = new KNotification(QStringLiteral("CaptivePortal"), KNotification::CloseOnTimeout, this);
+    notification->setActions(QStringList{i18n("Log in")});
+    notification->setComponentName(QStringLiteral("networkmanagement"));
+    if (connection) {
+        notification->setTitle(connection->id());
+    } else {
+        notification->setTitle(i18n("Network authentication"));
+    }
+    notification->setText(i18n("You need to log in to this network"));
+    notification->sendEvent();
+    const QUrl portalUrl = m_portalUrl;
+    connect(notification, &KNotification::action1Activated, this, [portalUrl] () {
+        QDesktopServices::openUrl(portalUrl);
+    });
+    m_notification = notification;
+}
+
+void PortalMonitor::closeLoginNotification()
+{
+    m_notifiedConnection.clear();
+    if (m_notification) {
+        m_notification->close();
+    }
+}
+
+void PortalMonitor::loadCache()
+{
+    KSharedConfigPtr config = KSharedConfig::openConfig(QStringLiteral("plasma-nm-portals"), KConfig::SimpleConfig, QStandardPaths::GenericCacheLocation);
+    const QDateTime expiration = QDateTime::currentDateTime().addDays(-PORTAL_CACHE_EXPIRATION);
+
+    Q_FOREACH (const QString &key, config->groupList()) {
+        // SSID entries were written by earlier versions, saveCache() drops them
+        if (key.startsWith(QLatin1String("ssid:"))) {
+            continue;
+        }
+
+        KConfigGroup grp(config, key);
+        PortalState state;
+        state.portal = grp.readEntry(QLatin1String("Portal"), false);
+        state.loggedIn = grp.readEntry(QLatin1String("LoggedIn"), false);
+        state.lastSeen = grp.readEntry(QLatin1String("LastSeen"), QDateTime());
+        if (state.lastSeen.isValid() && state.lastSeen > expiration) {
+            m_cache.insert(key, state);
+        }
+    }
+}
+
+void PortalMonitor::saveCache()
+{
+    KSharedConfigPtr config = KSharedConfig::openConfig(QStringLiteral("plasma-nm-portals"), KConfig::SimpleConfig, QStandardPaths::GenericCacheLocation);
+
+    Q_FOREACH (const QString &key, config->groupList()) {
+        if (!m_cache.contains(key)) {
+            config->deleteGroup(key);
+        }
+    }
+
+    QHash<QString, PortalState>::const_iterator it = m_cache.constBegin();
+    for (; it != m_cache.constEnd(); ++it) {
+        KConfigGroup grp(config, it.key());
+        grp.writeEntry(QLatin1String("Portal"), it->portal);
+        grp.writeEntry(QLatin1String("LoggedIn"), it->loggedIn);
+        grp.writeEntry(QLatin1String("LastSeen"), it->lastSeen);
+    }
+
+    config->sync();
+}
@@ -24,7 +24,13 @@
 
 #include <NetworkManagerQt/Manager>
 
+#include <QDateTime>
+#include <QHash>
 #include <QObject>
+#include <QPointer>
+#include <QUrl>
+
+class KNotification;
 
 class PortalMonitor : public QObject
 {
@@ -35,7 +41,34 @@ public:
 
 private Q_SLOTS:
     void connectivityChanged(NetworkManager::Connectivity connectivity);
+    void primaryConnectionChanged(const QString &path);
     void checkConnectivity();
+
+private:
+    struct PortalState {
+        // Whether the network is a captive portal, not cleared by logging in
+        bool portal = false;
+        // Whether the network had full connectivity when it was last seen
+        bool loggedIn = false;
+        QDateTime lastSeen;
+    };
+
+    /**
+     * @brief cacheKeys returns keys the primary connection is cached under,
+     * the BSSID of the access point first, then the connection uuid
+     */
+    QStringList cacheKeys(const NetworkManager::ActiveConnection::Ptr &connection) const;
+    void updateCache(const NetworkManager::ActiveConnection::Ptr &connection, bool portal);
+    void showLoginNotification(const NetworkManager::ActiveConnection::Ptr &connection);
+    void closeLoginNotification();
+    void loadCache();
+    void saveCache();
+
+    QHash<QString, PortalState> m_cache;
+    // Connection we already asked the user to log in to, until connectivity is full again
+    QString m_notifiedConnection;
+    QPointer<KNotification> m_notification;
+    QUrl m_portalUrl;
 };
 
 #endif // PLASMA_NM_PORTAL_MONITOR_H
@@ -22,9 +22,12 @@
 
 #include "passworddialog.h"
 #include "secretagent.h"
+#include "walletworker.h"
 
+#include "configuration.h"
 #include "debug.h"
 
+#include <NetworkManagerQt/Manager>
 #include <NetworkManagerQt/Settings>
 #include <NetworkManagerQt/ConnectionSettings>
 #include <NetworkManagerQt/GenericTypes>
@@ -35,7 +38,11 @@
 #include <NetworkManagerQt/WirelessSetting>
 
 #include <QStringBuilder>
+#include <QDataStream>
+#include <QDBusConnection>
 #include <QDialog>
+#include <QThread>
+#include <QTimer>
 
 #include <KPluginFactory>
 #include <KWindowSystem>
@@ -43,20 +50,104 @@
 #include <KConfigGroup>
 #include <KWallet/Wallet>
 
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Each cache entry gets pages of its own, so locking and unlocking one entry
+// never touches memory of another one
+static char *allocateLockedSecrets(int size, size_t &mappedSize)
+{
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    mappedSize = ((size + pageSize - 1) / pageSize) * pageSize;
+
+    void *data = mmap(0, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        return 0;
+    }
+
+    if (mlock(data, mappedSize) != 0) {
+        qCDebug(PLASMA_NM) << "Failed to lock memory for cached secrets";
+        munmap(data, mappedSize);
+        return 0;
+    }
+#ifdef MADV_DONTDUMP
+    madvise(data, mappedSize, MADV_DONTDUMP);
+#endif
+
+    return static_cast<char *>(data);
+}
+
+// Overwrites cached secrets once they are dropped, copies handed out while
+// they were cached are not covered
+static void wipeSecrets(char *&data, size_t mappedSize)
+{
+    if (!data) {
+        return;
+    }
+
+    memset(data, 0, mappedSize);
+    munlock(data, mappedSize);
+    munmap(data, mappedSize);
+    data = 0;
+}
+
 SecretAgent::SecretAgent(QObject* parent)
     : NetworkManager::SecretAgent("org.kde.plasma.networkmanagement", parent)
+    , m_secretsCacheTimeout(Configuration::secretsCacheTimeout())
+    , m_secretsCacheTimer(new QTimer(this))
     , m_openWalletFailed(false)
-    , m_wallet(0)
+    , m_walletOpen(false)
+    , m_walletOpening(false)
+    , m_lastCallId(0)
+    , m_walletWorker(new WalletWorker)
+    , m_walletThread(new QThread(this))
     , m_dialog(0)
 {
     connect(NetworkManager::notifier(), &NetworkManager::Notifier::serviceDisappeared, this, &SecretAgent::killDialogs);
 
+    // All wallet I/O happens in its own thread, results come back as queued signals
+    m_walletWorker->moveToThread(m_walletThread);
+    connect(m_walletThread, &QThread::finished, m_walletWorker, &QObject::deleteLater);
+    connect(m_walletWorker, &WalletWorker::opened, this, &SecretAgent::walletOpened);
+    connect(m_walletWorker, &WalletWorker::closed, this, &SecretAgent::walletClosed);
+    connect(m_walletWorker, &WalletWorker::secretsRead, this, &SecretAgent::walletSecretsRead);
+    connect(m_walletWorker, &WalletWorker::operationFinished, this, &SecretAgent::walletOperationFinished);
+    m_walletThread->start();
+
+    QDBusConnection::systemBus().connect(QStringLiteral("org.freedesktop.login1"),
+                                         QStringLiteral("/org/freedesktop/login1"),
+                                         QStringLiteral("org.freedesktop.login1.Manager"),
+                                         QStringLiteral("PrepareForSleep"),
+                                         this,
+                                         SLOT(onPrepareForSleep(bool)));
+
+    if (m_secretsCacheTimeout > 0) {
+        m_secretsCacheClock.start();
+        m_secretsCacheTimer->setInterval(m_secretsCacheTimeout * 1000);
+        connect(m_secretsCacheTimer, &QTimer::timeout, this, &SecretAgent::expireCachedSecrets);
+        prefetchAutoconnectSecrets();
+    }
+
     // We have to import secrets previously stored in plaintext files
     importSecretsFromPlainTextFiles();
 }
 
 SecretAgent::~SecretAgent()
 {
+    m_walletThread->quit();
+    m_walletThread->wait();
+
+    expireCachedSecrets();
+    QHash<QString, CachedSecrets>::iterator it = m_secretsCache.begin();
+    for (; it != m_secretsCache.end(); ++it) {
+        wipeSecrets(it->data, it->mappedSize);
+    }
+}
+
+void SecretAgent::openWallet()
+{
+    useWallet();
 }
 
 NMVariantMapMap SecretAgent::GetSecrets(const NMVariantMapMap &connection, const QDBusObjectPath &connection_path, const QString &setting_name,
@@ -69,12 +160,9 @@ NMVariantMapMap SecretAgent::GetSecrets(const NMVariantMapMap &connection, const
     qCDebug(PLASMA_NM) << "Flags:" << flags;
 
     const QString callId = connection_path.path() % setting_name;
-    Q_FOREACH (const SecretsRequest & request, m_calls) {
-        if (request == callId) {
-            qCWarning(PLASMA_NM) << "GetSecrets was called again! This should not happen, cancelling first call" << connection_path.path() << setting_name;
-            CancelGetSecrets(connection_path, setting_name);
-            break;
-        }
+    if (m_requests.contains(callId)) {
+        qCWarning(PLASMA_NM) << "GetSecrets was called again! This should not happen, cancelling first call" << connection_path.path() << setting_name;
+        CancelGetSecrets(connection_path, setting_name);
     }
 
     setDelayedReply(true);
@@ -86,7 +174,8 @@ NMVariantMapMap SecretAgent::GetSecrets(const NMVariantMapMap &connection, const
     request.hints = hints;
     request.setting_name = setting_name;
     request.message = message();
-    m_calls << request;
+    enqueueRequest(request);
+    Q_EMIT secretsRequested(connection_path.path());
 
     processNext();
 
@@ -107,10 +196,11 @@ void SecretAgent::SaveSecrets(const NMVariantMapMap &connection, const QDBusObje
         type = SecretsRequest::DeleteSecrets;
     }
     SecretsRequest request(type);
+    request.callId = nextCallId();
     request.connection = connection;
     request.connection_path = connection_path;
     request.message = message();
-    m_calls << request;
+    enqueueRequest(request);
 
     processNext();
 }
@@ -123,10 +213,11 @@ void SecretAgent::DeleteSecrets(const NMVariantMapMap &connection, const QDBusOb
 
     setDelayedReply(true);
     SecretsRequest request(SecretsRequest::DeleteSecrets);
+    request.callId = nextCallId();
     request.connection = connection;
     request.connection_path = connection_path;
     request.message = message();
-    m_calls << request;
+    enqueueRequest(request);
 
     processNext();
 }
@@ -137,20 +228,20 @@ void SecretAgent::CancelGetSecrets(const QDBusObjectPath &connection_path, const
     qCDebug(PLASMA_NM) << "Path:" << connection_path.path();
     qCDebug(PLASMA_NM) << "Setting name:" << setting_name;
 
-    QString callId = connection_path.path() % setting_name;
-    for (int i = 0; i < m_calls.size(); ++i) {
-        SecretsRequest request = m_calls.at(i);
-        if (request.type == SecretsRequest::GetSecrets && callId == request.callId) {
-            if (m_dialog == request.dialog) {
-                m_dialog = 0;
-            }
-            delete request.dialog;
-            sendError(SecretAgent::AgentCanceled,
-                      QLatin1String("Agent canceled the password dialog"),
-                      request.message);
-            m_calls.removeAt(i);
-            break;
+    const QString callId = connection_path.path() % setting_name;
+    QHash<QString, SecretsRequest>::iterator it = m_requests.find(callId);
+    if (it != m_requests.end() && it->type == SecretsRequest::GetSecrets) {
+        if (m_dialog && m_dialog == it->dialog) {
+            m_dialog = 0;
+            m_dialogCallId.clear();
         }
+        delete it->dialog;
+        sendError(SecretAgent::AgentCanceled,
+                  QLatin1String("Agent canceled the password dialog"),
+                  it->message);
+        // The run-queue entry is dropped lazily by processNext()
+        m_requests.erase(it);
+        Q_EMIT secretsRequestFinished(connection_path.path());
     }
 
     processNext();
@@ -158,195 +249,256 @@ void SecretAgent::CancelGetSecrets(const QDBusObjectPath &connection_path, const
 
 void SecretAgent::dialogAccepted()
 {
-    for (int i = 0; i < m_calls.size(); ++i) {
-        SecretsRequest request = m_calls[i];
-        if (request.type == SecretsRequest::GetSecrets && request.dialog == m_dialog) {
-            NMStringMap tmpOpenconnectSecrets;
-            NMVariantMapMap connection = request.dialog->secrets();
-            if (connection.contains(QLatin1String("vpn"))) {
-                if (connection.value(QStringLiteral("vpn")).contains(QLatin1String("tmp-secrets"))) {
-                    QVariantMap vpnSetting = connection.value(QLatin1String("vpn"));
-                    tmpOpenconnectSecrets = qdbus_cast<NMStringMap>(vpnSetting.take(QLatin1String("tmp-secrets")));
-                    connection.insert(QLatin1String("vpn"), vpnSetting);
-                }
+    if (m_requests.contains(m_dialogCallId)) {
+        const SecretsRequest request = m_requests.take(m_dialogCallId);
+        NMStringMap tmpOpenconnectSecrets;
+        NMVariantMapMap connection = request.dialog->secrets();
+        if (connection.contains(QLatin1String("vpn"))) {
+            if (connection.value(QStringLiteral("vpn")).contains(QLatin1String("tmp-secrets"))) {
+                QVariantMap vpnSetting = connection.value(QLatin1String("vpn"));
+                tmpOpenconnectSecrets = qdbus_cast<NMStringMap>(vpnSetting.take(QLatin1String("tmp-secrets")));
+                connection.insert(QLatin1String("vpn"), vpnSetting);
             }
+        }
 
-            sendSecrets(connection, request.message);
-            NetworkManager::ConnectionSettings::Ptr connectionSettings = NetworkManager::ConnectionSettings::Ptr(new NetworkManager::ConnectionSettings(connection));
-            NetworkManager::ConnectionSettings::Ptr completeConnectionSettings;
-            NetworkManager::Connection::Ptr con = NetworkManager::findConnectionByUuid(connectionSettings->uuid());
-            if (con) {
-                completeConnectionSettings = con->settings();
-            } else {
-                completeConnectionSettings = connectionSettings;
-            }
-            if (request.saveSecretsWithoutReply && completeConnectionSettings->connectionType() != NetworkManager::ConnectionSettings::Vpn) {
-                bool requestOffline = true;
-                if (completeConnectionSettings->connectionType() == NetworkManager::ConnectionSettings::Gsm) {
-                    NetworkManager::GsmSetting::Ptr gsmSetting = completeConnectionSettings->setting(NetworkManager::Setting::Gsm).staticCast<NetworkManager::GsmSetting>();
-                    if (gsmSetting) {
-                        if (gsmSetting->passwordFlags().testFlag(NetworkManager::Setting::NotSaved) ||
-                            gsmSetting->passwordFlags().testFlag(NetworkManager::Setting::NotRequired)) {
-                            requestOffline = false;
-                        } else if (gsmSetting->pinFlags().testFlag(NetworkManager::Setting::NotSaved) ||
-                                   gsmSetting->pinFlags().testFlag(NetworkManager::Setting::NotRequired)) {
-                            requestOffline = false;
-                        }
+        sendSecrets(connection, request.message);
+        NetworkManager::ConnectionSettings::Ptr connectionSettings = NetworkManager::ConnectionSettings::Ptr(new NetworkManager::ConnectionSettings(connection));
+        NetworkManager::ConnectionSettings::Ptr completeConnectionSettings;
+        NetworkManager::Connection::Ptr con = NetworkManager::findConnectionByUuid(connectionSettings->uuid());
+        if (con) {
+            completeConnectionSettings = con->settings();
+        } else {
+            completeConnectionSettings = connectionSettings;
+        }
+        if (request.saveSecretsWithoutReply && completeConnectionSettings->connectionType() != NetworkManager::ConnectionSettings::Vpn) {
+            bool requestOffline = true;
+            if (completeConnectionSettings->connectionType() == NetworkManager::ConnectionSettings::Gsm) {
+                NetworkManager::GsmSetting::Ptr gsmSetting = completeConnectionSettings->setting(NetworkManager::Setting::Gsm).staticCast<NetworkManager::GsmSetting>();
+                if (gsmSetting) {
+                    if (gsmSetting->passwordFlags().testFlag(NetworkManager::Setting::NotSaved) ||
+                        gsmSetting->passwordFlags().testFlag(NetworkManager::Setting::NotRequired)) {
+                        requestOffline = false;
+                    } else if (gsmSetting->pinFlags().testFlag(NetworkManager::Setting::NotSaved) ||
+                               gsmSetting->pinFlags().testFlag(NetworkManager::Setting::NotRequired)) {
+                        requestOffline = false;
                     }
-                } else if (completeConnectionSettings->connectionType() == NetworkManager::ConnectionSettings::Wireless) {
-                    NetworkManager::WirelessSecuritySetting::Ptr wirelessSecuritySetting = completeConnectionSettings->setting(NetworkManager::Setting::WirelessSecurity).staticCast<NetworkManager::WirelessSecuritySetting>();
-                    if (wirelessSecuritySetting && wirelessSecuritySetting->keyMgmt() == NetworkManager::WirelessSecuritySetting::WpaEap) {
-                        NetworkManager::Security8021xSetting::Ptr security8021xSetting = completeConnectionSettings->setting(NetworkManager::Setting::Security8021x).staticCast<NetworkManager::Security8021xSetting>();
-                        if (security8021xSetting) {
-                            if (security8021xSetting->eapMethods().contains(NetworkManager::Security8021xSetting::EapMethodFast) ||
-                                security8021xSetting->eapMethods().contains(NetworkManager::Security8021xSetting::EapMethodTtls) ||
-                                security8021xSetting->eapMethods().contains(NetworkManager::Security8021xSetting::EapMethodPeap)) {
-                                if (security8021xSetting->passwordFlags().testFlag(NetworkManager::Setting::NotSaved) ||
-                                    security8021xSetting->passwordFlags().testFlag(NetworkManager::Setting::NotRequired)) {
-                                    requestOffline = false;
-                                }
+                }
+            } else if (completeConnectionSettings->connectionType() == NetworkManager::ConnectionSettings::Wireless) {
+                NetworkManager::WirelessSecuritySetting::Ptr wirelessSecuritySetting = completeConnectionSettings->setting(NetworkManager::Setting::WirelessSecurity).staticCast<NetworkManager::WirelessSecuritySetting>();
+                if (wirelessSecuritySetting && wirelessSecuritySetting->keyMgmt() == NetworkManager::WirelessSecuritySetting::WpaEap) {
+                    NetworkManager::Security8021xSetting::Ptr security8021xSetting = completeConnectionSettings->setting(NetworkManager::Setting::Security8021x).staticCast<NetworkManager::Security8021xSetting>();
+                    if (security8021xSetting) {
+                        if (security8021xSetting->eapMethods().contains(NetworkManager::Security8021xSetting::EapMethodFast) ||
+                            security8021xSetting->eapMethods().contains(NetworkManager::Security8021xSetting::EapMethodTtls) ||
+                            security8021xSetting->eapMethods().contains(NetworkManager::Security8021xSetting::EapMethodPeap)) {
+                            if (security8021xSetting->passwordFlags().testFlag(NetworkManager::Setting::NotSaved) ||
+                                security8021xSetting->passwordFlags().testFlag(NetworkManager::Setting::NotRequired)) {
+                                requestOffline = false;
                             }
                         }
                     }
                 }
+            }
 
-                if (requestOffline) {
-                    SecretsRequest requestOffline(SecretsRequest::SaveSecrets);
-                    requestOffline.connection = connection;
-                    requestOffline.connection_path = request.connection_path;
-                    requestOffline.saveSecretsWithoutReply = true;
-                    m_calls << requestOffline;
+            if (requestOffline) {
+                SecretsRequest requestOffline(SecretsRequest::SaveSecrets);
+                requestOffline.callId = nextCallId();
+                requestOffline.connection = connection;
+                requestOffline.connection_path = request.connection_path;
+                requestOffline.saveSecretsWithoutReply = true;
+                enqueueRequest(requestOffline);
+            }
+        } else if (request.saveSecretsWithoutReply && completeConnectionSettings->connectionType() == NetworkManager::ConnectionSettings::Vpn && !tmpOpenconnectSecrets.isEmpty()) {
+            NetworkManager::VpnSetting::Ptr vpnSetting = completeConnectionSettings->setting(NetworkManager::Setting::Vpn).staticCast<NetworkManager::VpnSetting>();
+            if (vpnSetting) {
+                NMStringMap data = vpnSetting->data();
+                NMStringMap secrets = vpnSetting->secrets();
+
+                // Load secrets from auth dialog which are returned back to NM
+                if (connection.value(QLatin1String("vpn")).contains(QLatin1String("secrets"))) {
+                    secrets.unite(qdbus_cast<NMStringMap>(connection.value(QLatin1String("vpn")).value(QLatin1String("secrets"))));
                 }
-            } else if (request.saveSecretsWithoutReply && completeConnectionSettings->connectionType() == NetworkManager::ConnectionSettings::Vpn && !tmpOpenconnectSecrets.isEmpty()) {
-                NetworkManager::VpnSetting::Ptr vpnSetting = completeConnectionSettings->setting(NetworkManager::Setting::Vpn).staticCast<NetworkManager::VpnSetting>();
-                if (vpnSetting) {
-                    NMStringMap data = vpnSetting->data();
-                    NMStringMap secrets = vpnSetting->secrets();
-
-                    // Load secrets from auth dialog which are returned back to NM
-                    if (connection.value(QLatin1String("vpn")).contains(QLatin1String("secrets"))) {
-                        secrets.unite(qdbus_cast<NMStringMap>(connection.value(QLatin1String("vpn")).value(QLatin1String("secrets"))));
-                    }
 
-                    // Load temporary secrets from auth dialog which are not returned to NM
-                    Q_FOREACH (const QString &key, tmpOpenconnectSecrets.keys()) {
-                        if (secrets.contains(QLatin1Literal("save_passwords")) && secrets.value(QLatin1Literal("save_passwords")) == QLatin1String("yes")) {
-                            data.insert(key + QLatin1String("-flags"), QString::number(NetworkManager::Setting::AgentOwned));
-                        } else {
-                            data.insert(key + QLatin1String("-flags"), QString::number(NetworkManager::Setting::NotSaved));
-                        }
-                        secrets.insert(key, tmpOpenconnectSecrets.value(key));
+                // Load temporary secrets from auth dialog which are not returned to NM
+                Q_FOREACH (const QString &key, tmpOpenconnectSecrets.keys()) {
+                    if (secrets.contains(QLatin1Literal("save_passwords")) && secrets.value(QLatin1Literal("save_passwords")) == QLatin1String("yes")) {
+                        data.insert(key + QLatin1String("-flags"), QString::number(NetworkManager::Setting::AgentOwned));
+                    } else {
+                        data.insert(key + QLatin1String("-flags"), QString::number(NetworkManager::Setting::NotSaved));
                     }
+                    secrets.insert(key, tmpOpenconnectSecrets.value(key));
+                }
 
-                    vpnSetting->setData(data);
-                    vpnSetting->setSecrets(secrets);
-                    if (!con) {
-                        con = NetworkManager::findConnection(request.connection_path.path());
-                    }
+                vpnSetting->setData(data);
+                vpnSetting->setSecrets(secrets);
+                if (!con) {
+                    con = NetworkManager::findConnection(request.connection_path.path());
+                }
 
-                    if (con) {
-                        con->update(completeConnectionSettings->toMap());
-                    }
+                if (con) {
+                    con->update(completeConnectionSettings->toMap());
                 }
             }
-
-            m_calls.removeAt(i);
-            break;
         }
+
+        Q_EMIT secretsRequestFinished(request.connection_path.path());
     }
 
     m_dialog->deleteLater();
     m_dialog = 0;
+    m_dialogCallId.clear();
 
     processNext();
 }
 
 void SecretAgent::dialogRejected()
 {
-    for (int i = 0; i < m_calls.size(); ++i) {
-        SecretsRequest request = m_calls[i];
-        if (request.type == SecretsRequest::GetSecrets && request.dialog == m_dialog) {
-            sendError(SecretAgent::UserCanceled,
-                      QLatin1String("User canceled the password dialog"),
-                      request.message);
-            m_calls.removeAt(i);
-            break;
-        }
+    if (m_requests.contains(m_dialogCallId)) {
+        const SecretsRequest request = m_requests.take(m_dialogCallId);
+        sendError(SecretAgent::UserCanceled,
+                  QLatin1String("User canceled the password dialog"),
+                  request.message);
+        Q_EMIT secretsRequestFinished(request.connection_path.path());
     }
 
     m_dialog->deleteLater();
     m_dialog = 0;
+    m_dialogCallId.clear();
 
     processNext();
 }
 
 void SecretAgent::killDialogs()
 {
-    int i = 0;
-    while (i < m_calls.size()) {
-        SecretsRequest request = m_calls[i];
-        if (request.type == SecretsRequest::GetSecrets) {
-            delete request.dialog;
-            m_calls.removeAt(i);
+    QHash<QString, SecretsRequest>::iterator it = m_requests.begin();
+    while (it != m_requests.end()) {
+        if (it->type == SecretsRequest::GetSecrets) {
+            delete it->dialog;
+            const QString connectionPath = it->connection_path.path();
+            it = m_requests.erase(it);
+            Q_EMIT secretsRequestFinished(connectionPath);
+        } else {
+            ++it;
         }
-
-        ++i;
     }
+
+    m_dialog = 0;
+    m_dialogCallId.clear();
 }
 
 void SecretAgent::walletOpened(bool success)
 {
-    if (!success) {
-        m_openWalletFailed = true;
-        m_wallet->deleteLater();
-        m_wallet = 0;
-    } else {
-        m_openWalletFailed = false;
-    }
+    m_walletOpening = false;
+    m_walletOpen = success;
+    m_openWalletFailed = !success;
 
     processNext();
+
+    if (!m_prefetchQueue.isEmpty()) {
+        QTimer::singleShot(0, this, &SecretAgent::processPrefetch);
+    }
 }
 
 void SecretAgent::walletClosed()
 {
-    if (m_wallet) {
-        m_wallet->deleteLater();
+    m_walletOpen = false;
+    m_walletOpening = false;
+}
+
+void SecretAgent::walletSecretsRead(const QString &callId, const QString &key, const NMStringMap &secrets)
+{
+    cacheSecrets(key, secrets);
+
+    // Prefetched secrets don't belong to any request
+    if (callId.isEmpty()) {
+        return;
+    }
+
+    SecretsRequest *request = findRequest(callId);
+    if (request && request->walletOperation == SecretsRequest::OperationPending) {
+        request->walletSecrets = secrets;
+        request->walletOperation = SecretsRequest::OperationFinished;
+        processNext();
+    }
+}
+
+void SecretAgent::walletOperationFinished(const QString &callId, bool success)
+{
+    SecretsRequest *request = findRequest(callId);
+    if (request && request->walletOperation == SecretsRequest::OperationPending) {
+        request->walletSuccess = success;
+        request->walletOperation = SecretsRequest::OperationFinished;
+        processNext();
     }
-    m_wallet = 0;
+}
+
+SecretsRequest *SecretAgent::findRequest(const QString &callId)
+{
+    QHash<QString, SecretsRequest>::iterator it = m_requests.find(callId);
+    if (it == m_requests.end()) {
+        return 0;
+    }
+    return &it.value();
+}
+
+QString SecretAgent::nextCallId() const
+{
+    return QStringLiteral("request-") + QString::number(++m_lastCallId);
+}
+
+void SecretAgent::enqueueRequest(const SecretsRequest &request)
+{
+    m_requests.insert(request.callId, request);
+    m_queue.append(request.callId);
 }
 
 void SecretAgent::processNext()
 {
-    int i = 0;
-    while (i < m_calls.size()) {
-        SecretsRequest &request = m_calls[i];
+    QLinkedList<QString>::iterator it = m_queue.begin();
+    while (it != m_queue.end()) {
+        QHash<QString, SecretsRequest>::iterator requestIt = m_requests.find(*it);
+        // Requests which were answered or canceled meanwhile
+        if (requestIt == m_requests.end()) {
+            it = m_queue.erase(it);
+            continue;
+        }
+
+        SecretsRequest &request = requestIt.value();
+        bool processed = false;
         switch (request.type) {
         case SecretsRequest::GetSecrets:
-            if (processGetSecrets(request)) {
-                m_calls.removeAt(i);
-                continue;
+            processed = processGetSecrets(request);
+            if (processed) {
+                Q_EMIT secretsRequestFinished(request.connection_path.path());
             }
             break;
         case SecretsRequest::SaveSecrets:
-            if (processSaveSecrets(request)) {
-                m_calls.removeAt(i);
-                continue;
-            }
+            processed = processSaveSecrets(request);
             break;
         case SecretsRequest::DeleteSecrets:
-            if (processDeleteSecrets(request)) {
-                m_calls.removeAt(i);
-                continue;
-            }
+            processed = processDeleteSecrets(request);
             break;
         }
-        ++i;
+
+        if (processed) {
+            m_requests.erase(requestIt);
+            it = m_queue.erase(it);
+        } else {
+            ++it;
+        }
     }
 }
 
 bool SecretAgent::processGetSecrets(SecretsRequest &request) const
 {
-    if (m_dialog) {
+    // The request is being answered by its own password dialog
+    if (request.dialog) {
+        return false;
+    }
+
+    // Only one dialog is shown at a time, requests which don't need one
+    // are served from the wallet without waiting for it
+    if (request.needsInteraction && m_dialog) {
         return false;
     }
 
@@ -359,16 +511,26 @@ bool SecretAgent::processGetSecrets(SecretsRequest &request) const
     const bool isVpn = (setting->type() == NetworkManager::Setting::Vpn);
 
     NMStringMap secretsMap;
-    if (!requestNew && useWallet()) {
-        if (m_wallet->isOpen()) {
-            if (m_wallet->hasFolder("Network Management") && m_wallet->setFolder("Network Management")) {
-                QString key = QLatin1Char('{') % connectionSettings->uuid() % QLatin1Char('}') % QLatin1Char(';') % request.setting_name;
-                m_wallet->readMap(key, secretsMap);
+    const QString key = QLatin1Char('{') % connectionSettings->uuid() % QLatin1Char('}') % QLatin1Char(';') % request.setting_name;
+    if (requestNew) {
+        // Stored secrets didn't work, don't offer them again
+        invalidateCachedSecrets(connectionSettings->uuid());
+    } else if (request.walletOperation == SecretsRequest::OperationFinished) {
+        secretsMap = request.walletSecrets;
+    } else if (readCachedSecrets(key, secretsMap)) {
+        qCDebug(PLASMA_NM) << Q_FUNC_INFO << "Using cached secrets for" << key;
+    } else if (useWallet()) {
+        if (m_walletOpen) {
+            if (request.walletOperation == SecretsRequest::NoOperation) {
+                request.walletOperation = SecretsRequest::OperationPending;
+                QMetaObject::invokeMethod(m_walletWorker, "readSecrets", Qt::QueuedConnection,
+                                          Q_ARG(QString, request.callId), Q_ARG(QString, key));
             }
+            qCDebug(PLASMA_NM) << Q_FUNC_INFO << "Waiting for the wallet to read secrets";
         } else {
             qCDebug(PLASMA_NM) << Q_FUNC_INFO << "Waiting for the wallet to open";
-            return false;
         }
+        return false;
     }
 
     if (!secretsMap.isEmpty()) {
@@ -382,6 +544,11 @@ bool SecretAgent::processGetSecrets(SecretsRequest &request) const
     }
 
     if (requestNew || (allowInteraction && !setting->needSecrets(requestNew).isEmpty()) || (allowInteraction && userRequested) || (isVpn && allowInteraction)) {
+        if (m_dialog) {
+            request.needsInteraction = true;
+            return false;
+        }
+
         m_dialog = new PasswordDialog(connectionSettings, request.flags, request.setting_name);
         connect(m_dialog, &PasswordDialog::accepted, this, &SecretAgent::dialogAccepted);
         connect(m_dialog, &PasswordDialog::rejected, this, &SecretAgent::dialogRejected);
@@ -395,6 +562,7 @@ bool SecretAgent::processGetSecrets(SecretsRequest &request) const
             return true;
         } else {
             request.dialog = m_dialog;
+            m_dialogCallId = request.callId;
             request.saveSecretsWithoutReply = !connectionSettings->permissions().isEmpty();
             m_dialog->show();
             KWindowSystem::setState(m_dialog->winId(), NET::KeepAbove);
@@ -433,33 +601,40 @@ bool SecretAgent::processGetSecrets(SecretsRequest &request) const
 
 bool SecretAgent::processSaveSecrets(SecretsRequest &request) const
 {
-    if (useWallet()) {
-        if (m_wallet->isOpen()) {
-            NetworkManager::ConnectionSettings connectionSettings(request.connection);
+    if (request.walletOperation == SecretsRequest::OperationPending) {
+        return false;
+    }
+
+    if (request.walletOperation == SecretsRequest::NoOperation) {
+        NetworkManager::ConnectionSettings connectionSettings(request.connection);
+        invalidateCachedSecrets(connectionSettings.uuid());
 
-            if (!m_wallet->hasFolder("Network Management")) {
-                m_wallet->createFolder("Network Management");
+        if (useWallet()) {
+            if (!m_walletOpen) {
+                qCDebug(PLASMA_NM) << Q_FUNC_INFO << "Waiting for the wallet to open";
+                return false;
             }
 
-            if (m_wallet->setFolder("Network Management")) {
-                Q_FOREACH (const NetworkManager::Setting::Ptr &setting, connectionSettings.settings()) {
-                    NMStringMap secretsMap = setting->secretsToStringMap();
+            QVariantMap entries;
+            Q_FOREACH (const NetworkManager::Setting::Ptr &setting, connectionSettings.settings()) {
+                NMStringMap secretsMap = setting->secretsToStringMap();
 
-                    if (!secretsMap.isEmpty()) {
-                        QString entryName = QLatin1Char('{') % connectionSettings.uuid() % QLatin1Char('}') % QLatin1Char(';') % setting->name();
-                        m_wallet->writeMap(entryName, secretsMap);
-                    }
+                if (!secretsMap.isEmpty()) {
+                    QString entryName = QLatin1Char('{') % connectionSettings.uuid() % QLatin1Char('}') % QLatin1Char(';') % setting->name();
+                    entries.insert(entryName, QVariant::fromValue(secretsMap));
                 }
-            } else if (!request.saveSecretsWithoutReply) {
-                sendError(SecretAgent::InternalError,
-                          QLatin1String("Could not store secrets in the wallet."),
-                          request.message);
-                return true;
             }
-        } else {
-            qCDebug(PLASMA_NM) << Q_FUNC_INFO << "Waiting for the wallet to open";
+
+            request.walletOperation = SecretsRequest::OperationPending;
+            QMetaObject::invokeMethod(m_walletWorker, "writeSecrets", Qt::QueuedConnection,
+                                      Q_ARG(QString, request.callId), Q_ARG(QVariantMap, entries));
             return false;
         }
+    } else if (!request.walletSuccess && !request.saveSecretsWithoutReply) {
+        sendError(SecretAgent::InternalError,
+                  QLatin1String("Could not store secrets in the wallet."),
+                  request.message);
+        return true;
     }
 
     if (!request.saveSecretsWithoutReply) {
@@ -474,21 +649,28 @@ bool SecretAgent::processSaveSecrets(SecretsRequest &request) const
 
 bool SecretAgent::processDeleteSecrets(SecretsRequest &request) const
 {
-    if (useWallet()) {
-        if (m_wallet->isOpen()) {
-            if (m_wallet->hasFolder("Network Management") && m_wallet->setFolder("Network Management")) {
-                NetworkManager::ConnectionSettings connectionSettings(request.connection);
-                Q_FOREACH (const NetworkManager::Setting::Ptr &setting, connectionSettings.settings()) {
-                    QString entryName = QLatin1Char('{') % connectionSettings.uuid() % QLatin1Char('}') % QLatin1Char(';') % setting->name();
-                    Q_FOREACH (const QString &entry, m_wallet->entryList()) {
-                        if (entry.startsWith(entryName)) {
-                            m_wallet->removeEntry(entryName);
-                        }
-                    }
-                }
+    if (request.walletOperation == SecretsRequest::OperationPending) {
+        return false;
+    }
+
+    if (request.walletOperation == SecretsRequest::NoOperation) {
+        NetworkManager::ConnectionSettings connectionSettings(request.connection);
+        invalidateCachedSecrets(connectionSettings.uuid());
+
+        if (useWallet()) {
+            if (!m_walletOpen) {
+                qCDebug(PLASMA_NM) << Q_FUNC_INFO << "Waiting for the wallet to open";
+                return false;
             }
-        } else {
-            qCDebug(PLASMA_NM) << Q_FUNC_INFO << "Waiting for the wallet to open";
+
+            QStringList entryNames;
+            Q_FOREACH (const NetworkManager::Setting::Ptr &setting, connectionSettings.settings()) {
+                entryNames << QLatin1Char('{') % connectionSettings.uuid() % QLatin1Char('}') % QLatin1Char(';') % setting->name();
+            }
+
+            request.walletOperation = SecretsRequest::OperationPending;
+            QMetaObject::invokeMethod(m_walletWorker, "removeSecrets", Qt::QueuedConnection,
+                                      Q_ARG(QString, request.callId), Q_ARG(QStringList, entryNames));
             return false;
         }
     }
@@ -503,7 +685,7 @@ bool SecretAgent::processDeleteSecrets(SecretsRequest &request) const
 
 bool SecretAgent::useWallet() const
 {
-    if (m_wallet) {
+    if (m_walletOpen || m_walletOpening) {
         return true;
     }
 
@@ -515,20 +697,172 @@ bool SecretAgent::useWallet() const
     }
 
     if (KWallet::Wallet::isEnabled()) {
-        m_wallet = KWallet::Wallet::openWallet(KWallet::Wallet::LocalWallet(), 0, KWallet::Wallet::Asynchronous);
-        if (m_wallet) {
-            connect(m_wallet, &KWallet::Wallet::walletOpened, this, &SecretAgent::walletOpened);
-            connect(m_wallet, &KWallet::Wallet::walletClosed, this, &SecretAgent::walletClosed);
-            return true;
+        m_walletOpening = true;
+        QMetaObject::invokeMethod(m_walletWorker, "open", Qt::QueuedConnection);
+        return true;
+    }
+
+    return false;
+}
+
+bool SecretAgent::readCachedSecrets(const QString &key, NMStringMap &secrets) const
+{
+    if (m_secretsCacheTimeout <= 0 || !m_secretsCache.contains(key)) {
+        return false;
+    }
+
+    CachedSecrets &cached = m_secretsCache[key];
+    if (cached.expiration <= m_secretsCacheClock.elapsed()) {
+        wipeSecrets(cached.data, cached.mappedSize);
+        m_secretsCache.remove(key);
+        return false;
+    }
+
+    // Read in place, without copying the buffer out of locked memory
+    const QByteArray data = QByteArray::fromRawData(cached.data, cached.size);
+    QDataStream stream(data);
+    stream >> secrets;
+    return !secrets.isEmpty();
+}
+
+void SecretAgent::cacheSecrets(const QString &key, const NMStringMap &secrets) const
+{
+    if (m_secretsCacheTimeout <= 0 || secrets.isEmpty()) {
+        return;
+    }
+
+    if (m_secretsCache.contains(key)) {
+        CachedSecrets &previous = m_secretsCache[key];
+        wipeSecrets(previous.data, previous.mappedSize);
+        m_secretsCache.remove(key);
+    }
+
+    QByteArray serialized;
+    QDataStream stream(&serialized, QIODevice::WriteOnly);
+    stream << secrets;
+
+    CachedSecrets cached;
+    cached.data = allocateLockedSecrets(serialized.size(), cached.mappedSize);
+    if (cached.data) {
+        memcpy(cached.data, serialized.constData(), serialized.size());
+        cached.size = serialized.size();
+    }
+    memset(serialized.data(), 0, serialized.size());
+    // Secrets which can't be kept in locked memory are not cached at all
+    if (!cached.data) {
+        return;
+    }
+    cached.expiration = m_secretsCacheClock.elapsed() + m_secretsCacheTimeout * 1000;
+    m_secretsCache.insert(key, cached);
+
+    if (!m_secretsCacheTimer->isActive()) {
+        m_secretsCacheTimer->start();
+    }
+}
+
+void SecretAgent::invalidateCachedSecrets(const QString &uuid) const
+{
+    const QString prefix = QLatin1Char('{') % uuid % QLatin1Char('}');
+    QHash<QString, CachedSecrets>::iterator it = m_secretsCache.begin();
+    while (it != m_secretsCache.end()) {
+        if (it.key().startsWith(prefix)) {
+            wipeSecrets(it->data, it->mappedSize);
+            it = m_secretsCache.erase(it);
         } else {
-            qCWarning(PLASMA_NM) << "Error opening kwallet.";
+            ++it;
         }
-    } else if (m_wallet) {
-        m_wallet->deleteLater();
-        m_wallet = 0;
     }
+}
 
-    return false;
+void SecretAgent::expireCachedSecrets()
+{
+    const qint64 now = m_secretsCacheClock.elapsed();
+    QHash<QString, CachedSecrets>::iterator it = m_secretsCache.begin();
+    while (it != m_secretsCache.end()) {
+        if (it.value().expiration <= now) {
+            wipeSecrets(it->data, it->mappedSize);
+            it = m_secretsCache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (m_secretsCache.isEmpty()) {
+        m_secretsCacheTimer->stop();
+    }
+}
+
+void SecretAgent::prefetchSecrets(const QStringList &uuids)
+{
+    if (m_secretsCacheTimeout <= 0) {
+        return;
+    }
+
+    Q_FOREACH (const QString &uuid, uuids) {
+        if (!m_prefetchQueue.contains(uuid)) {
+            m_prefetchQueue << uuid;
+        }
+    }
+
+    // Secrets are read once the wallet is opened
+    if (useWallet() && m_walletOpen) {
+        QTimer::singleShot(0, this, &SecretAgent::processPrefetch);
+    }
+}
+
+void SecretAgent::prefetchAutoconnectSecrets()
+{
+    QStringList uuids;
+    Q_FOREACH (const NetworkManager::Device::Ptr &device, NetworkManager::networkInterfaces()) {
+        if (device->activeConnection()) {
+            continue;
+        }
+        Q_FOREACH (const NetworkManager::Connection::Ptr &connection, device->availableConnections()) {
+            if (connection->settings()->autoconnect() && !uuids.contains(connection->uuid())) {
+                uuids << connection->uuid();
+            }
+        }
+    }
+
+    prefetchSecrets(uuids);
+}
+
+void SecretAgent::processPrefetch()
+{
+    if (!m_walletOpen) {
+        return;
+    }
+
+    if (m_prefetchQueue.isEmpty()) {
+        return;
+    }
+
+    // One connection per event loop iteration, so reads for pending requests are
+    // queued to the wallet thread in between, results are cached by walletSecretsRead()
+    const QString prefix = QLatin1Char('{') % m_prefetchQueue.takeFirst() % QLatin1Char('}') % QLatin1Char(';');
+    QMetaObject::invokeMethod(m_walletWorker, "readSecretsWithPrefix", Qt::QueuedConnection, Q_ARG(QString, prefix));
+
+    if (!m_prefetchQueue.isEmpty()) {
+        QTimer::singleShot(0, this, &SecretAgent::processPrefetch);
+    }
+}
+
+void SecretAgent::onPrepareForSleep(bool sleep)
+{
+    if (sleep) {
+        m_activeConnectionsBeforeSleep.clear();
+        Q_FOREACH (const NetworkManager::ActiveConnection::Ptr &connection, NetworkManager::activeConnections()) {
+            m_activeConnectionsBeforeSleep << connection->uuid();
+        }
+    } else if (m_secretsCacheTimeout > 0) {
+        // Connections which were active before sleep are the most likely to be activated again
+        prefetchSecrets(m_activeConnectionsBeforeSleep);
+        prefetchAutoconnectSecrets();
+    } else if (!m_activeConnectionsBeforeSleep.isEmpty()) {
+        // Without the cache there is nowhere to keep prefetched secrets, but opening the wallet
+        // is what takes long and it can be done before the resumed connections ask for them
+        useWallet();
+    }
 }
 
 bool SecretAgent::hasSecrets(const NMVariantMapMap &connection) const
@@ -25,11 +25,14 @@
 
 #include <NetworkManagerQt/SecretAgent>
 
-namespace KWallet {
-class Wallet;
-}
+#include <QElapsedTimer>
+#include <QLinkedList>
+
+class QTimer;
 
 class PasswordDialog;
+class WalletWorker;
+class QThread;
 
 class SecretsRequest {
 public:
@@ -38,16 +41,32 @@ public:
         SaveSecrets,
         DeleteSecrets
     };
+    enum WalletOperation {
+        NoOperation,
+        OperationPending,
+        OperationFinished
+    };
     explicit SecretsRequest(Type _type) :
         type(_type),
+        walletOperation(NoOperation),
+        walletSuccess(false),
         flags(NetworkManager::SecretAgent::None),
         saveSecretsWithoutReply(false),
+        needsInteraction(false),
         dialog(0)
     {}
     inline bool operator==(const QString &other) const {
         return callId == other;
     }
     Type type;
+    /**
+     * State of the wallet read or write done for this
+     * request by the wallet thread, walletSecrets and
+     * walletSuccess hold its result once finished.
+     */
+    WalletOperation walletOperation;
+    NMStringMap walletSecrets;
+    bool walletSuccess;
     QString callId;
     NMVariantMapMap connection;
     QDBusObjectPath connection_path;
@@ -61,6 +80,12 @@ public:
      * should skip the DBus reply.
      */
     bool saveSecretsWithoutReply;
+    /**
+     * True when the request can't be answered without
+     * a password dialog, such requests wait until the
+     * currently shown dialog is closed.
+     */
+    bool needsInteraction;
     QDBusMessage message;
     PasswordDialog *dialog;
 };
@@ -72,18 +97,36 @@ public:
     explicit SecretAgent(QObject* parent = 0);
     virtual ~SecretAgent();
 
+    /**
+     * Starts opening the wallet in advance, so the first secrets request doesn't have to wait for it
+     */
+    void openWallet();
+
 public Q_SLOTS:
     virtual NMVariantMapMap GetSecrets(const NMVariantMapMap&, const QDBusObjectPath&, const QString&, const QStringList&, uint) Q_DECL_OVERRIDE;
     virtual void SaveSecrets(const NMVariantMapMap &connection, const QDBusObjectPath &connection_path) Q_DECL_OVERRIDE;
     virtual void DeleteSecrets(const NMVariantMapMap &, const QDBusObjectPath &) Q_DECL_OVERRIDE;
     virtual void CancelGetSecrets(const QDBusObjectPath &, const QString &) Q_DECL_OVERRIDE;
 
+Q_SIGNALS:
+    /**
+     * Emitted when NetworkManager asks for secrets of given connection and when the request is answered
+     * @connectionPath - d-bus path of the connection
+     */
+    void secretsRequested(const QString &connectionPath);
+    void secretsRequestFinished(const QString &connectionPath);
+
 private Q_SLOTS:
     void dialogAccepted();
     void dialogRejected();
     void killDialogs();
     void walletOpened(bool success);
     void walletClosed();
+    void walletSecretsRead(const QString &callId, const QString &key, const NMStringMap &secrets);
+    void walletOperationFinished(const QString &callId, bool success);
+    void onPrepareForSleep(bool sleep);
+    void processPrefetch();
+    void expireCachedSecrets();
 
 private:
     void processNext();
@@ -99,7 +142,7 @@ private:
     bool processDeleteSecrets(SecretsRequest &request) const;
     /**
      * @brief useWallet checks if the KWallet system is enabled
-     * and tries to open it async.
+     * and tries to open it async in the wallet thread.
      * @return return true if the method should use the wallet,
      * the caller MUST always check if the wallet is opened.
      */
@@ -113,10 +156,63 @@ private:
     bool hasSecrets(const NMVariantMapMap &connection) const;
     void sendSecrets(const NMVariantMapMap &secrets, const QDBusMessage &message) const;
 
+    /**
+     * @brief readCachedSecrets returns secrets previously read from the wallet
+     * @param key wallet entry of the secrets
+     * @param secrets filled with the cached secrets
+     * @return true if the secrets were cached and didn't expire yet
+     */
+    bool readCachedSecrets(const QString &key, NMStringMap &secrets) const;
+    void cacheSecrets(const QString &key, const NMStringMap &secrets) const;
+    /**
+     * @brief invalidateCachedSecrets drops all cached secrets of the connection
+     * @param uuid uuid of the connection
+     */
+    void invalidateCachedSecrets(const QString &uuid) const;
+    /**
+     * @brief prefetchSecrets reads secrets of given connections from the wallet
+     * into the cache, the reads are done by the wallet thread
+     */
+    void prefetchSecrets(const QStringList &uuids);
+    void prefetchAutoconnectSecrets();
+
+    struct CachedSecrets {
+        // Serialized secrets in mlock'ed pages owned by this entry
+        char *data = 0;
+        int size = 0;
+        size_t mappedSize = 0;
+        qint64 expiration = 0;
+    };
+
+    // Cache of wallet entries, disabled when m_secretsCacheTimeout is 0
+    int m_secretsCacheTimeout;
+    mutable QHash<QString, CachedSecrets> m_secretsCache;
+    QElapsedTimer m_secretsCacheClock;
+    QTimer *m_secretsCacheTimer;
+    QStringList m_prefetchQueue;
+    QStringList m_activeConnectionsBeforeSleep;
+
+    /**
+     * @brief findRequest looks up a pending request
+     * @param callId id of the request
+     * @return the request or 0 if it was already answered
+     */
+    SecretsRequest *findRequest(const QString &callId);
+    QString nextCallId() const;
+    void enqueueRequest(const SecretsRequest &request);
+
     mutable bool m_openWalletFailed;
-    mutable KWallet::Wallet *m_wallet;
+    mutable bool m_walletOpen;
+    mutable bool m_walletOpening;
+    mutable uint m_lastCallId;
+    WalletWorker *m_walletWorker;
+    QThread *m_walletThread;
     mutable PasswordDialog *m_dialog;
-    QList<SecretsRequest> m_calls;
+    // Request the password dialog belongs to
+    mutable QString m_dialogCallId;
+    // Pending requests by callId, m_queue keeps their arrival order
+    QHash<QString, SecretsRequest> m_requests;
+    QLinkedList<QString> m_queue;
 
     void importSecretsFromPlainTextFiles();
 
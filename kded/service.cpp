@@ -25,6 +25,7 @@
 
 #include <KPluginFactory>
 
+#include "activationtracer.h"
 #include "secretagent.h"
 #include "notification.h"
 #include "monitor.h"
@@ -43,6 +44,7 @@ K_PLUGIN_FACTORY_WITH_JSON(NetworkManagementServiceFactory,
 class NetworkManagementServicePrivate
 {
     public:
+    ActivationTracer *tracer = nullptr;
     SecretAgent *agent = nullptr;
     Notification *notification = nullptr;
     Monitor *monitor = nullptr;
@@ -66,8 +68,17 @@ void NetworkManagementService::init()
 {
     Q_D(NetworkManagementService);
 
+    if (!d->tracer) {
+        d->tracer = new ActivationTracer(this);
+        connect(d->tracer, &ActivationTracer::traceFinished, this, &NetworkManagementService::activationTraceFinished);
+    }
+
     if (!d->agent) {
         d->agent = new SecretAgent(this);
+        connect(d->agent, &SecretAgent::secretsRequested, d->tracer, &ActivationTracer::secretsRequested);
+        connect(d->agent, &SecretAgent::secretsRequestFinished, d->tracer, &ActivationTracer::secretsRequestFinished);
+        // Don't let the first connection after login wait for the wallet
+        d->agent->openWallet();
     }
 
     if (!d->notification) {
@@ -83,6 +94,44 @@ void NetworkManagementService::init()
     }
 }
 
+void NetworkManagementService::traceActivationRequested(const QString &connection, qlonglong timestamp)
+{
+    Q_D(NetworkManagementService);
+
+    if (d->tracer) {
+        d->tracer->activationRequested(connection, timestamp);
+    }
+}
+
+void NetworkManagementService::traceActivationReplied(const QString &connection, qlonglong timestamp, const QString &error)
+{
+    Q_D(NetworkManagementService);
+
+    if (d->tracer) {
+        d->tracer->activationReplied(connection, timestamp, error);
+    }
+}
+
+QVariantList NetworkManagementService::activationTraces() const
+{
+    Q_D(const NetworkManagementService);
+
+    if (d->tracer) {
+        return d->tracer->traces();
+    }
+    return QVariantList();
+}
+
+QVariantMap NetworkManagementService::lastActivationTrace(const QString &uuid) const
+{
+    Q_D(const NetworkManagementService);
+
+    if (d->tracer) {
+        return d->tracer->lastTrace(uuid);
+    }
+    return QVariantMap();
+}
+
 void NetworkManagementService::slotRegistered(const QDBusObjectPath &path)
 {
     if (path.path() == QLatin1String("/modules/networkmanagement")) {
@@ -42,9 +42,14 @@ public:
 
 public Q_SLOTS:
     Q_SCRIPTABLE void init();
+    Q_SCRIPTABLE void traceActivationRequested(const QString &connection, qlonglong timestamp);
+    Q_SCRIPTABLE void traceActivationReplied(const QString &connection, qlonglong timestamp, const QString &error);
+    Q_SCRIPTABLE QVariantList activationTraces() const;
+    Q_SCRIPTABLE QVariantMap lastActivationTrace(const QString &uuid) const;
 
 Q_SIGNALS:
     Q_SCRIPTABLE void registered();
+    Q_SCRIPTABLE void activationTraceFinished(const QVariantMap &trace);
 
 private Q_SLOTS:
     void slotRegistered(const QDBusObjectPath &path);
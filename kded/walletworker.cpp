@@ -0,0 +1,147 @@
+/*
+    Copyright 2026 agent <agent@local>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "walletworker.h"
+#include "debug.h"
+
+#include <KWallet/Wallet>
+
+WalletWorker::WalletWorker(QObject *parent)
+    : QObject(parent)
+    , m_wallet(0)
+{
+    qRegisterMetaType<NMStringMap>("NMStringMap");
+}
+
+WalletWorker::~WalletWorker()
+{
+    delete m_wallet;
+}
+
+void WalletWorker::open()
+{
+    if (m_wallet) {
+        if (m_wallet->isOpen()) {
+            Q_EMIT opened(true);
+        }
+        return;
+    }
+
+    m_wallet = KWallet::Wallet::openWallet(KWallet::Wallet::LocalWallet(), 0, KWallet::Wallet::Asynchronous);
+    if (m_wallet) {
+        connect(m_wallet, &KWallet::Wallet::walletOpened, this, &WalletWorker::walletOpened);
+        connect(m_wallet, &KWallet::Wallet::walletClosed, this, &WalletWorker::walletClosed);
+    } else {
+        qCWarning(PLASMA_NM) << "Error opening kwallet.";
+        Q_EMIT opened(false);
+    }
+}
+
+void WalletWorker::readSecrets(const QString &callId, const QString &key)
+{
+    NMStringMap secretsMap;
+    if (setFolder(false)) {
+        m_wallet->readMap(key, secretsMap);
+    }
+
+    Q_EMIT secretsRead(callId, key, secretsMap);
+}
+
+void WalletWorker::readSecretsWithPrefix(const QString &prefix)
+{
+    if (!setFolder(false)) {
+        return;
+    }
+
+    Q_FOREACH (const QString &entry, m_wallet->entryList()) {
+        if (entry.startsWith(prefix)) {
+            NMStringMap secretsMap;
+            m_wallet->readMap(entry, secretsMap);
+            Q_EMIT secretsRead(QString(), entry, secretsMap);
+        }
+    }
+}
+
+void WalletWorker::writeSecrets(const QString &callId, const QVariantMap &entries)
+{
+    if (!setFolder(true)) {
+        Q_EMIT operationFinished(callId, false);
+        return;
+    }
+
+    QVariantMap::const_iterator it = entries.constBegin();
+    for (; it != entries.constEnd(); ++it) {
+        m_wallet->writeMap(it.key(), it.value().value<NMStringMap>());
+    }
+
+    Q_EMIT operationFinished(callId, true);
+}
+
+void WalletWorker::removeSecrets(const QString &callId, const QStringList &prefixes)
+{
+    if (setFolder(false)) {
+        Q_FOREACH (const QString &entry, m_wallet->entryList()) {
+            Q_FOREACH (const QString &prefix, prefixes) {
+                if (entry.startsWith(prefix)) {
+                    m_wallet->removeEntry(entry);
+                    break;
+                }
+            }
+        }
+    }
+
+    Q_EMIT operationFinished(callId, true);
+}
+
+void WalletWorker::walletOpened(bool success)
+{
+    if (!success) {
+        m_wallet->deleteLater();
+        m_wallet = 0;
+    }
+
+    Q_EMIT opened(success);
+}
+
+void WalletWorker::walletClosed()
+{
+    if (m_wallet) {
+        m_wallet->deleteLater();
+    }
+    m_wallet = 0;
+
+    Q_EMIT closed();
+}
+
+bool WalletWorker::setFolder(bool create)
+{
+    if (!m_wallet || !m_wallet->isOpen()) {
+        return false;
+    }
+
+    if (!m_wallet->hasFolder("Network Management")) {
+        if (!create) {
+            return false;
+        }
+        m_wallet->createFolder("Network Management");
+    }
+
+    return m_wallet->setFolder("Network Management");
+}
@@ -0,0 +1,85 @@
+/*
+    Copyright 2026 agent <agent@local>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLASMA_NM_WALLET_WORKER_H
+#define PLASMA_NM_WALLET_WORKER_H
+
+#include <QObject>
+#include <QVariantMap>
+
+#include <NetworkManagerQt/GenericTypes>
+
+namespace KWallet {
+class Wallet;
+}
+
+/**
+ * Owns the connection to KWallet and performs all wallet reads and writes.
+ * It lives in its own thread, so slow wallet back-ends don't stall the rest
+ * of the kded module. All slots are meant to be invoked through queued
+ * connections and are processed in the order they were called.
+ */
+class WalletWorker : public QObject
+{
+Q_OBJECT
+public:
+    explicit WalletWorker(QObject *parent = 0);
+    virtual ~WalletWorker();
+
+public Q_SLOTS:
+    void open();
+    /**
+     * Reads one wallet entry, the result is reported by secretsRead()
+     * @callId - identifier of the request which asked for the secrets
+     * @key - name of the wallet entry
+     */
+    void readSecrets(const QString &callId, const QString &key);
+    /**
+     * Reads all wallet entries starting with given prefix, each of them is reported
+     * by secretsRead() with an empty callId
+     */
+    void readSecretsWithPrefix(const QString &prefix);
+    /**
+     * Writes wallet entries, the result is reported by operationFinished()
+     * @entries - name of the wallet entry mapped to NMStringMap with secrets
+     */
+    void writeSecrets(const QString &callId, const QVariantMap &entries);
+    /**
+     * Removes all wallet entries starting with any of given prefixes, the result is reported by operationFinished()
+     */
+    void removeSecrets(const QString &callId, const QStringList &prefixes);
+
+Q_SIGNALS:
+    void opened(bool success);
+    void closed();
+    void secretsRead(const QString &callId, const QString &key, const NMStringMap &secrets);
+    void operationFinished(const QString &callId, bool success);
+
+private Q_SLOTS:
+    void walletOpened(bool success);
+    void walletClosed();
+
+private:
+    bool setFolder(bool create);
+
+    KWallet::Wallet *m_wallet;
+};
+
+#endif // PLASMA_NM_WALLET_WORKER_H
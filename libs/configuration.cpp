@@ -66,3 +66,25 @@ void Configuration::setManageVirtualConnections(bool manage)
         grp.writeEntry(QLatin1String("ManageVirtualConnections"), manage);
     }
 }
+
+int Configuration::secretsCacheTimeout()
+{
+    KSharedConfigPtr config = KSharedConfig::openConfig(QLatin1String("plasma-nm"));
+    KConfigGroup grp(config, QLatin1String("General"));
+
+    if (grp.isValid()) {
+        return grp.readEntry(QLatin1String("SecretsCacheTimeout"), 0);
+    }
+
+    return 0;
+}
+
+void Configuration::setSecretsCacheTimeout(int timeout)
+{
+    KSharedConfigPtr config = KSharedConfig::openConfig(QLatin1String("plasma-nm"));
+    KConfigGroup grp(config, QLatin1String("General"));
+
+    if (grp.isValid()) {
+        grp.writeEntry(QLatin1String("SecretsCacheTimeout"), timeout);
+    }
+}
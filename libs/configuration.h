@@ -36,6 +36,13 @@ public:
 
     static bool manageVirtualConnections();
     static void setManageVirtualConnections(bool manage);
+
+    /**
+     * Number of seconds the secret agent keeps secrets read from the wallet in memory,
+     * 0 disables the cache
+     */
+    static int secretsCacheTimeout();
+    static void setSecretsCacheTimeout(int timeout);
 };
 
 #endif // PLAMA_NM_CONFIGURATION_H
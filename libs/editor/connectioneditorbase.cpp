@@ -39,6 +39,8 @@
 #include "settings/wifisecurity.h"
 #include "settings/wiredconnectionwidget.h"
 #include "settings/wiredsecurity.h"
+#include "uiutils.h"
+#include "vpnpluginregistry.h"
 #include "vpnuiplugin.h"
 
 #include <NetworkManagerQt/ActiveConnection>
@@ -54,24 +56,54 @@
 #include <NetworkManagerQt/WirelessSetting>
 #include <NetworkManagerQt/WirelessDevice>
 
+#include <QVBoxLayout>
+
 #include <KIconLoader>
 #include <KLocalizedString>
 #include <KNotification>
-#include <KServiceTypeTrader>
 #include <KUser>
 
+// Placeholder of a tab which creates the real setting widget when shown for the first time
+class LazyTabPlaceholder : public QWidget
+{
+public:
+    explicit LazyTabPlaceholder(const std::function<void(QWidget *)> &materialize)
+        : m_materialize(materialize)
+    {
+        QVBoxLayout *layout = new QVBoxLayout(this);
+        layout->setContentsMargins(0, 0, 0, 0);
+    }
+
+protected:
+    void showEvent(QShowEvent *event) override
+    {
+        if (m_materialize) {
+            std::function<void(QWidget *)> materialize = m_materialize;
+            m_materialize = nullptr;
+            materialize(this);
+        }
+        QWidget::showEvent(event);
+    }
+
+private:
+    std::function<void(QWidget *)> m_materialize;
+};
+
 ConnectionEditorBase::ConnectionEditorBase(const NetworkManager::ConnectionSettings::Ptr &connection,
                                            QWidget *parent, Qt::WindowFlags f)
     : QWidget(parent, f)
     , m_initialized(false)
     , m_valid(false)
-    , m_pendingReplies(0)
     , m_connection(connection)
+    , m_connectionWidget(nullptr)
 {
 }
 
 ConnectionEditorBase::ConnectionEditorBase(QWidget *parent, Qt::WindowFlags f)
     : QWidget(parent, f)
+    , m_initialized(false)
+    , m_valid(false)
+    , m_connectionWidget(nullptr)
 {
 }
 
@@ -87,18 +119,65 @@ void ConnectionEditorBase::setConnection(const NetworkManager::ConnectionSetting
     m_connection = connection;
     m_initialized = false;
 
+    // Replies for the previous connection are not interesting anymore
+    qDeleteAll(m_pendingReplies);
+    m_pendingReplies.clear();
+
     // Reset UI setting widgets
     delete m_connectionWidget;
     m_connectionWidget = nullptr;
     qDeleteAll(m_settingWidgets);
     m_settingWidgets.clear();
+    Q_FOREACH (const LazyTab &tab, m_lazyTabs) {
+        delete tab.placeholder;
+    }
+    m_lazyTabs.clear();
+    m_loadedSecrets.clear();
+    m_savedSettings.clear();
 
     initialize();
 }
 
 NMVariantMapMap ConnectionEditorBase::setting() const
 {
-    NMVariantMapMap settings = m_connectionWidget->setting();
+    NMVariantMapMap settings;
+    if (m_connectionWidget) {
+        settings = m_connectionWidget->setting();
+    } else {
+        const QString connectionType = NetworkManager::Setting::typeAsString(NetworkManager::Setting::Connection);
+        settings.insert(connectionType, m_connection->toMap().value(connectionType));
+    }
+
+    // Tabs which were never shown keep the values they were loaded with
+    Q_FOREACH (const LazyTab &tab, m_lazyTabs) {
+        if (tab.materialized || tab.type == NetworkManager::Setting::typeAsString(NetworkManager::Setting::Connection)) {
+            continue;
+        }
+
+        const NetworkManager::Setting::SettingType settingType = NetworkManager::Setting::typeFromString(tab.type);
+        if (settingType == NetworkManager::Setting::WirelessSecurity) {
+            NetworkManager::WirelessSecuritySetting::Ptr securitySetting = m_connection->setting(settingType).staticCast<NetworkManager::WirelessSecuritySetting>();
+            if (securitySetting && securitySetting->keyMgmt() != NetworkManager::WirelessSecuritySetting::Unknown) {
+                settings.insert(tab.type, securitySetting->toMap());
+                if (securitySetting->keyMgmt() == NetworkManager::WirelessSecuritySetting::WpaEap ||
+                    (securitySetting->keyMgmt() == NetworkManager::WirelessSecuritySetting::Ieee8021x &&
+                     securitySetting->authAlg() != NetworkManager::WirelessSecuritySetting::Leap)) {
+                    settings.insert(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Security8021x),
+                                    m_connection->setting(NetworkManager::Setting::Security8021x)->toMap());
+                }
+            }
+        } else if (settingType == NetworkManager::Setting::Security8021x) {
+            NetworkManager::Setting::Ptr securitySetting = m_connection->setting(settingType);
+            if (securitySetting && !securitySetting->isNull()) {
+                settings.insert(tab.type, securitySetting->toMap());
+            }
+        } else {
+            NetworkManager::Setting::Ptr setting = m_connection->setting(settingType);
+            if (setting) {
+                settings.insert(tab.type, setting->toMap());
+            }
+        }
+    }
 
     Q_FOREACH (SettingWidget *widget, m_settingWidgets) {
         const QString type = widget->type();
@@ -148,6 +227,16 @@ NMVariantMapMap ConnectionEditorBase::setting() const
     return connectionSettings->toMap();
 }
 
+NMVariantMapMap ConnectionEditorBase::changedSettings(const NMVariantMapMap &settings) const
+{
+    return UiUtils::changedSettings(m_savedSettings, settings);
+}
+
+void ConnectionEditorBase::setSavedSetting(const NMVariantMapMap &settings)
+{
+    m_savedSettings = settings;
+}
+
 bool ConnectionEditorBase::isInitialized() const
 {
     return m_initialized;
@@ -176,6 +265,87 @@ void ConnectionEditorBase::addSettingWidget(SettingWidget *widget, const QString
     addWidget(widget, text);
 }
 
+void ConnectionEditorBase::addLazyWidget(const QString &type, const QString &text, const std::function<QWidget *()> &factory)
+{
+    // New connections have to be validated by all widgets right away
+    if (m_connection->id().isEmpty()) {
+        QWidget *widget = factory();
+        if (ConnectionWidget *connectionWidget = qobject_cast<ConnectionWidget *>(widget)) {
+            addConnectionWidget(connectionWidget, text);
+        } else {
+            addSettingWidget(static_cast<SettingWidget *>(widget), text);
+        }
+        return;
+    }
+
+    LazyTab tab;
+    tab.placeholder = new LazyTabPlaceholder([this] (QWidget *placeholder) {
+        materialize(placeholder);
+    });
+    tab.type = type;
+    tab.factory = factory;
+    tab.materialized = false;
+    m_lazyTabs << tab;
+
+    addWidget(tab.placeholder, text);
+}
+
+void ConnectionEditorBase::materialize(QWidget *placeholder)
+{
+    for (int i = 0; i < m_lazyTabs.size(); ++i) {
+        LazyTab &tab = m_lazyTabs[i];
+        if (tab.placeholder != placeholder || tab.materialized) {
+            continue;
+        }
+
+        tab.materialized = true;
+        QWidget *widget = tab.factory();
+        placeholder->layout()->addWidget(widget);
+
+        if (ConnectionWidget *connectionWidget = qobject_cast<ConnectionWidget *>(widget)) {
+            m_connectionWidget = connectionWidget;
+            connect(connectionWidget, &ConnectionWidget::settingChanged, this, &ConnectionEditorBase::settingChanged);
+        } else {
+            SettingWidget *settingWidget = static_cast<SettingWidget *>(widget);
+            m_settingWidgets << settingWidget;
+            connect(settingWidget, &SettingWidget::settingChanged, this, &ConnectionEditorBase::settingChanged);
+            connect(settingWidget, &SettingWidget::validChanged, this, &ConnectionEditorBase::validChanged);
+
+            // Secrets which arrived before the widget existed
+            Q_FOREACH (const QString &settingName, m_loadedSecrets) {
+                loadSecrets(settingWidget, settingName);
+            }
+
+            connectWifiWidgets();
+            // Validity is re-checked once secrets arrive
+            if (m_pendingReplies.isEmpty()) {
+                validChanged(settingWidget->isValid());
+            }
+        }
+
+        KAcceleratorManager::manage(widget);
+        break;
+    }
+}
+
+void ConnectionEditorBase::connectWifiWidgets()
+{
+    WifiConnectionWidget *wifiWidget = nullptr;
+    WifiSecurity *wifiSecurity = nullptr;
+    Q_FOREACH (SettingWidget *widget, m_settingWidgets) {
+        if (widget->type() == NetworkManager::Setting::typeAsString(NetworkManager::Setting::Wireless)) {
+            wifiWidget = static_cast<WifiConnectionWidget *>(widget);
+        } else if (widget->type() == NetworkManager::Setting::typeAsString(NetworkManager::Setting::WirelessSecurity)) {
+            wifiSecurity = static_cast<WifiSecurity *>(widget);
+        }
+    }
+
+    if (wifiWidget && wifiSecurity) {
+        connect(wifiWidget, static_cast<void (WifiConnectionWidget::*)(const QString &)>(&WifiConnectionWidget::ssidChanged),
+                wifiSecurity, &WifiSecurity::onSsidChanged, Qt::UniqueConnection);
+    }
+}
+
 void ConnectionEditorBase::initialize()
 {
     const bool emptyConnection = m_connection->id().isEmpty();
@@ -186,60 +356,77 @@ void ConnectionEditorBase::initialize()
     }
 
     // General configuration common to all connection types
-    ConnectionWidget *connectionWidget = new ConnectionWidget(m_connection);
-    addConnectionWidget(connectionWidget, i18nc("General", "General configuration"));
+    addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Connection), i18nc("General", "General configuration"), [this] () {
+        return new ConnectionWidget(m_connection);
+    });
 
-    // Add the rest of widgets
+    // Add the rest of widgets, they are created when their tab is shown first
     QString serviceType;
     if (type == NetworkManager::ConnectionSettings::Wired) {
-        WiredConnectionWidget *wiredWidget = new WiredConnectionWidget(m_connection->setting(NetworkManager::Setting::Wired), this);
-        addSettingWidget(wiredWidget, i18n("Wired"));
-        WiredSecurity *wiredSecurity = new WiredSecurity(m_connection->setting(NetworkManager::Setting::Security8021x).staticCast<NetworkManager::Security8021xSetting>(), this);
-        addSettingWidget(wiredSecurity, i18n("802.1x Security"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Wired), i18n("Wired"), [this] () {
+            return new WiredConnectionWidget(m_connection->setting(NetworkManager::Setting::Wired), this);
+        });
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Security8021x), i18n("802.1x Security"), [this] () {
+            return new WiredSecurity(m_connection->setting(NetworkManager::Setting::Security8021x).staticCast<NetworkManager::Security8021xSetting>(), this);
+        });
     } else if (type == NetworkManager::ConnectionSettings::Wireless) {
-        WifiConnectionWidget *wifiWidget = new WifiConnectionWidget(m_connection->setting(NetworkManager::Setting::Wireless), this);
-        addSettingWidget(wifiWidget, i18n("Wi-Fi"));
-        WifiSecurity *wifiSecurity = new WifiSecurity(m_connection->setting(NetworkManager::Setting::WirelessSecurity),
-                m_connection->setting(NetworkManager::Setting::Security8021x).staticCast<NetworkManager::Security8021xSetting>(),
-                this);
-        addSettingWidget(wifiSecurity, i18n("Wi-Fi Security"));
-        connect(wifiWidget, static_cast<void (WifiConnectionWidget::*)(const QString &)>(&WifiConnectionWidget::ssidChanged), wifiSecurity, &WifiSecurity::onSsidChanged);
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Wireless), i18n("Wi-Fi"), [this] () {
+            return new WifiConnectionWidget(m_connection->setting(NetworkManager::Setting::Wireless), this);
+        });
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::WirelessSecurity), i18n("Wi-Fi Security"), [this] () {
+            return new WifiSecurity(m_connection->setting(NetworkManager::Setting::WirelessSecurity),
+                                    m_connection->setting(NetworkManager::Setting::Security8021x).staticCast<NetworkManager::Security8021xSetting>(),
+                                    this);
+        });
+        connectWifiWidgets();
     } else if (type == NetworkManager::ConnectionSettings::Pppoe) { // DSL
-        PppoeWidget *pppoeWidget = new PppoeWidget(m_connection->setting(NetworkManager::Setting::Pppoe), this);
-        addSettingWidget(pppoeWidget, i18n("DSL"));
-        WiredConnectionWidget *wiredWidget = new WiredConnectionWidget(m_connection->setting(NetworkManager::Setting::Wired), this);
-        addSettingWidget(wiredWidget, i18n("Wired"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Pppoe), i18n("DSL"), [this] () {
+            return new PppoeWidget(m_connection->setting(NetworkManager::Setting::Pppoe), this);
+        });
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Wired), i18n("Wired"), [this] () {
+            return new WiredConnectionWidget(m_connection->setting(NetworkManager::Setting::Wired), this);
+        });
     } else if (type == NetworkManager::ConnectionSettings::Gsm) { // GSM
-        GsmWidget *gsmWidget = new GsmWidget(m_connection->setting(NetworkManager::Setting::Gsm), this);
-        addSettingWidget(gsmWidget, i18n("Mobile Broadband (%1)", m_connection->typeAsString(m_connection->connectionType())));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Gsm), i18n("Mobile Broadband (%1)", m_connection->typeAsString(m_connection->connectionType())), [this] () {
+            return new GsmWidget(m_connection->setting(NetworkManager::Setting::Gsm), this);
+        });
     } else if (type == NetworkManager::ConnectionSettings::Cdma) { // CDMA
-        CdmaWidget *cdmaWidget = new CdmaWidget(m_connection->setting(NetworkManager::Setting::Cdma), this);
-        addSettingWidget(cdmaWidget, i18n("Mobile Broadband (%1)", m_connection->typeAsString(m_connection->connectionType())));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Cdma), i18n("Mobile Broadband (%1)", m_connection->typeAsString(m_connection->connectionType())), [this] () {
+            return new CdmaWidget(m_connection->setting(NetworkManager::Setting::Cdma), this);
+        });
     } else if (type == NetworkManager::ConnectionSettings::Bluetooth) {  // Bluetooth
-        BtWidget *btWidget = new BtWidget(m_connection->setting(NetworkManager::Setting::Bluetooth), this);
-        addSettingWidget(btWidget, i18n("Bluetooth"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Bluetooth), i18n("Bluetooth"), [this] () {
+            return new BtWidget(m_connection->setting(NetworkManager::Setting::Bluetooth), this);
+        });
         NetworkManager::BluetoothSetting::Ptr btSetting = m_connection->setting(NetworkManager::Setting::Bluetooth).staticCast<NetworkManager::BluetoothSetting>();
         if (btSetting->profileType() == NetworkManager::BluetoothSetting::Dun) {
-            GsmWidget *gsmWidget = new GsmWidget(m_connection->setting(NetworkManager::Setting::Gsm), this);
-            addSettingWidget(gsmWidget, i18n("GSM"));
-            PPPWidget *pppWidget = new PPPWidget(m_connection->setting(NetworkManager::Setting::Ppp), this);
-            addSettingWidget(pppWidget, i18n("PPP"));
+            addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Gsm), i18n("GSM"), [this] () {
+                return new GsmWidget(m_connection->setting(NetworkManager::Setting::Gsm), this);
+            });
+            addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Ppp), i18n("PPP"), [this] () {
+                return new PPPWidget(m_connection->setting(NetworkManager::Setting::Ppp), this);
+            });
         }
     } else if (type == NetworkManager::ConnectionSettings::Infiniband) { // Infiniband
-        InfinibandWidget *infinibandWidget = new InfinibandWidget(m_connection->setting(NetworkManager::Setting::Infiniband), this);
-        addSettingWidget(infinibandWidget, i18n("Infiniband"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Infiniband), i18n("Infiniband"), [this] () {
+            return new InfinibandWidget(m_connection->setting(NetworkManager::Setting::Infiniband), this);
+        });
     } else if (type == NetworkManager::ConnectionSettings::Bond) { // Bond
-        BondWidget *bondWidget = new BondWidget(m_connection->uuid(), m_connection->setting(NetworkManager::Setting::Bond), this);
-        addSettingWidget(bondWidget, i18n("Bond"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Bond), i18n("Bond"), [this] () {
+            return new BondWidget(m_connection->uuid(), m_connection->setting(NetworkManager::Setting::Bond), this);
+        });
     } else if (type == NetworkManager::ConnectionSettings::Bridge) { // Bridge
-        BridgeWidget *bridgeWidget = new BridgeWidget(m_connection->uuid(), m_connection->setting(NetworkManager::Setting::Bridge), this);
-        addSettingWidget(bridgeWidget, i18n("Bridge"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Bridge), i18n("Bridge"), [this] () {
+            return new BridgeWidget(m_connection->uuid(), m_connection->setting(NetworkManager::Setting::Bridge), this);
+        });
     } else if (type == NetworkManager::ConnectionSettings::Vlan) { // Vlan
-        VlanWidget *vlanWidget = new VlanWidget(m_connection->setting(NetworkManager::Setting::Vlan), this);
-        addSettingWidget(vlanWidget, i18n("Vlan"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Vlan), i18n("Vlan"), [this] () {
+            return new VlanWidget(m_connection->setting(NetworkManager::Setting::Vlan), this);
+        });
     } else if (type == NetworkManager::ConnectionSettings::Team) { // Team
-        TeamWidget *teamWidget = new TeamWidget(m_connection->uuid(), m_connection->setting(NetworkManager::Setting::Team), this);
-        addSettingWidget(teamWidget, i18n("Team"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Team), i18n("Team"), [this] () {
+            return new TeamWidget(m_connection->uuid(), m_connection->setting(NetworkManager::Setting::Team), this);
+        });
     } else if (type == NetworkManager::ConnectionSettings::Vpn) { // VPN
         QString error;
         VpnUiPlugin *vpnPlugin = 0;
@@ -249,13 +436,12 @@ void ConnectionEditorBase::initialize()
             qCWarning(PLASMA_NM) << "Missing VPN setting!";
         } else {
             serviceType = vpnSetting->serviceType();
-            vpnPlugin = KServiceTypeTrader::createInstanceFromQuery<VpnUiPlugin>(QString::fromLatin1("PlasmaNetworkManagement/VpnUiPlugin"),
-                        QString::fromLatin1("[X-NetworkManager-Services]=='%1'").arg(serviceType),
-                        this, QVariantList(), &error);
-            if (vpnPlugin && error.isEmpty()) {
+            vpnPlugin = VpnPluginRegistry::self()->plugin(serviceType, &error);
+            if (vpnPlugin) {
                 const QString shortName = serviceType.section('.', -1);
-                SettingWidget *vpnWidget = vpnPlugin->widget(vpnSetting, this);
-                addSettingWidget(vpnWidget, i18n("VPN (%1)", shortName));
+                addLazyWidget(vpnSetting->name(), i18n("VPN (%1)", shortName), [this, vpnPlugin, vpnSetting] () {
+                    return vpnPlugin->widget(vpnSetting, this);
+                });
             } else {
                 qCWarning(PLASMA_NM) << error << ", serviceType == " << serviceType;
             }
@@ -264,14 +450,16 @@ void ConnectionEditorBase::initialize()
 
     // PPP widget
     if (type == NetworkManager::ConnectionSettings::Pppoe || type == NetworkManager::ConnectionSettings::Cdma || type == NetworkManager::ConnectionSettings::Gsm) {
-        PPPWidget *pppWidget = new PPPWidget(m_connection->setting(NetworkManager::Setting::Ppp), this);
-        addSettingWidget(pppWidget, i18n("PPP"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Ppp), i18n("PPP"), [this] () {
+            return new PPPWidget(m_connection->setting(NetworkManager::Setting::Ppp), this);
+        });
     }
 
     // IPv4 widget
     if (!m_connection->isSlave()) {
-        IPv4Widget *ipv4Widget = new IPv4Widget(m_connection->setting(NetworkManager::Setting::Ipv4), this);
-        addSettingWidget(ipv4Widget, i18n("IPv4"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Ipv4), i18n("IPv4"), [this] () {
+            return new IPv4Widget(m_connection->setting(NetworkManager::Setting::Ipv4), this);
+        });
     }
 
     // IPv6 widget
@@ -290,15 +478,16 @@ void ConnectionEditorBase::initialize()
             || type == NetworkManager::ConnectionSettings::Bridge
             || type == NetworkManager::ConnectionSettings::Vlan
             || (type == NetworkManager::ConnectionSettings::Vpn && serviceType == QLatin1String("org.freedesktop.NetworkManager.openvpn"))) && !m_connection->isSlave()) {
-        IPv6Widget *ipv6Widget = new IPv6Widget(m_connection->setting(NetworkManager::Setting::Ipv6), this);
-        addSettingWidget(ipv6Widget, i18n("IPv6"));
+        addLazyWidget(NetworkManager::Setting::typeAsString(NetworkManager::Setting::Ipv6), i18n("IPv6"), [this] () {
+            return new IPv6Widget(m_connection->setting(NetworkManager::Setting::Ipv6), this);
+        });
     }
 
     // Re-check validation
     bool valid = true;
     Q_FOREACH (SettingWidget *widget, m_settingWidgets) {
         valid = valid && widget->isValid();
-        connect(widget, &SettingWidget::validChanged, this, &ConnectionEditorBase::validChanged);
+        connect(widget, &SettingWidget::validChanged, this, &ConnectionEditorBase::validChanged, Qt::UniqueConnection);
     }
 
     m_valid = valid;
@@ -310,137 +499,130 @@ void ConnectionEditorBase::initialize()
     if (!emptyConnection) {
         NetworkManager::Connection::Ptr connection = NetworkManager::findConnectionByUuid(m_connection->uuid());
         if (connection) {
-            QStringList requiredSecrets;
-            QString settingName;
-            QVariantMap setting;
-            QDBusPendingReply<NMVariantMapMap> reply;
-
-            if (m_connection->connectionType() == NetworkManager::ConnectionSettings::Adsl) {
-                NetworkManager::AdslSetting::Ptr adslSetting = connection->settings()->setting(NetworkManager::Setting::Adsl).staticCast<NetworkManager::AdslSetting>();
-                if (adslSetting && !adslSetting->needSecrets().isEmpty()) {
-                    requiredSecrets = adslSetting->needSecrets();
-                    setting = adslSetting->toMap();
-                    settingName = QLatin1String("adsl");
-                }
-            } else if (m_connection->connectionType() == NetworkManager::ConnectionSettings::Bluetooth) {
-                NetworkManager::GsmSetting::Ptr gsmSetting = connection->settings()->setting(NetworkManager::Setting::Gsm).staticCast<NetworkManager::GsmSetting>();
-                if (gsmSetting && !gsmSetting->needSecrets().isEmpty()) {
-                    requiredSecrets = gsmSetting->needSecrets();
-                    setting = gsmSetting->toMap();
-                    settingName = QLatin1String("gsm");
-                }
-            } else if (m_connection->connectionType() == NetworkManager::ConnectionSettings::Cdma) {
-                NetworkManager::CdmaSetting::Ptr cdmaSetting = connection->settings()->setting(NetworkManager::Setting::Cdma).staticCast<NetworkManager::CdmaSetting>();
-                if (cdmaSetting && !cdmaSetting->needSecrets().isEmpty()) {
-                    requiredSecrets = cdmaSetting->needSecrets();
-                    setting = cdmaSetting->toMap();
-                    settingName = QLatin1String("cdma");
-                }
-            } else if (m_connection->connectionType() == NetworkManager::ConnectionSettings::Gsm) {
-                NetworkManager::GsmSetting::Ptr gsmSetting = connection->settings()->setting(NetworkManager::Setting::Gsm).staticCast<NetworkManager::GsmSetting>();
-                if (gsmSetting && !gsmSetting->needSecrets().isEmpty()) {
-                    requiredSecrets = gsmSetting->needSecrets();
-                    setting = gsmSetting->toMap();
-                    settingName = QLatin1String("gsm");
-                }
-            } else if (m_connection->connectionType() == NetworkManager::ConnectionSettings::Pppoe) {
-                NetworkManager::PppoeSetting::Ptr pppoeSetting = connection->settings()->setting(NetworkManager::Setting::Pppoe).staticCast<NetworkManager::PppoeSetting>();
-                if (pppoeSetting && !pppoeSetting->needSecrets().isEmpty()) {
-                    requiredSecrets = pppoeSetting->needSecrets();
-                    setting = pppoeSetting->toMap();
-                    settingName = QLatin1String("pppoe");
-                }
-            } else if (m_connection->connectionType() == NetworkManager::ConnectionSettings::Wired) {
-                NetworkManager::Security8021xSetting::Ptr securitySetting = connection->settings()->setting(NetworkManager::Setting::Security8021x).staticCast<NetworkManager::Security8021xSetting>();
-                if (securitySetting && !securitySetting->needSecrets().isEmpty()) {
-                    requiredSecrets = securitySetting->needSecrets();
-                    setting = securitySetting->toMap();
-                    settingName = QLatin1String("802-1x");
-                }
-            } else if (m_connection->connectionType() == NetworkManager::ConnectionSettings::Wireless) {
+            QList<NetworkManager::Setting::SettingType> secretSettings;
+
+            switch (m_connection->connectionType()) {
+            case NetworkManager::ConnectionSettings::Adsl:
+                secretSettings << NetworkManager::Setting::Adsl;
+                break;
+            case NetworkManager::ConnectionSettings::Bluetooth:
+            case NetworkManager::ConnectionSettings::Gsm:
+                secretSettings << NetworkManager::Setting::Gsm;
+                break;
+            case NetworkManager::ConnectionSettings::Cdma:
+                secretSettings << NetworkManager::Setting::Cdma;
+                break;
+            case NetworkManager::ConnectionSettings::Pppoe:
+                secretSettings << NetworkManager::Setting::Pppoe << NetworkManager::Setting::Security8021x;
+                break;
+            case NetworkManager::ConnectionSettings::Wired:
+                secretSettings << NetworkManager::Setting::Security8021x;
+                break;
+            case NetworkManager::ConnectionSettings::Wireless: {
                 NetworkManager::WirelessSecuritySetting::Ptr wifiSecuritySetting = connection->settings()->setting(NetworkManager::Setting::WirelessSecurity).staticCast<NetworkManager::WirelessSecuritySetting>();
                 if (wifiSecuritySetting &&
                         (wifiSecuritySetting->keyMgmt() == NetworkManager::WirelessSecuritySetting::WpaEap ||
                          (wifiSecuritySetting->keyMgmt() == NetworkManager::WirelessSecuritySetting::WirelessSecuritySetting::Ieee8021x &&
                           wifiSecuritySetting->authAlg() != NetworkManager::WirelessSecuritySetting::Leap))) {
-                    NetworkManager::Security8021xSetting::Ptr securitySetting = connection->settings()->setting(NetworkManager::Setting::Security8021x).staticCast<NetworkManager::Security8021xSetting>();
-                    if (securitySetting && !securitySetting->needSecrets().isEmpty()) {
-                        requiredSecrets = securitySetting->needSecrets();
-                        setting = securitySetting->toMap();
-                        settingName = QLatin1String("802-1x");
-
-                        if (requiredSecrets.contains(NM_SETTING_802_1X_PASSWORD_RAW)) {
-                            requiredSecrets.removeAll(NM_SETTING_802_1X_PASSWORD_RAW);
-                        }
-                    }
+                    secretSettings << NetworkManager::Setting::Security8021x;
                 } else {
-                    if (!wifiSecuritySetting->needSecrets().isEmpty()) {
-                        requiredSecrets = wifiSecuritySetting->needSecrets();
-                        setting = wifiSecuritySetting->toMap();
-                        settingName = QLatin1String("802-11-wireless-security");
-                    }
+                    secretSettings << NetworkManager::Setting::WirelessSecurity;
                 }
-            } else if (m_connection->connectionType() == NetworkManager::ConnectionSettings::Vpn) {
-                settingName = QLatin1String("vpn");
+                break;
+            }
+            case NetworkManager::ConnectionSettings::Vpn:
+                secretSettings << NetworkManager::Setting::Vpn;
+                break;
+            default:
+                break;
             }
 
-            if (!requiredSecrets.isEmpty() || m_connection->connectionType() == NetworkManager::ConnectionSettings::Vpn) {
-                bool requestSecrets = false;
-                if (m_connection->connectionType() == NetworkManager::ConnectionSettings::Vpn) {
-                    requestSecrets = true;
-                } else {
-                    Q_FOREACH (const QString &secret, requiredSecrets) {
-                        if (setting.contains(secret + QLatin1String("-flags"))) {
-                            NetworkManager::Setting::SecretFlagType secretFlag = (NetworkManager::Setting::SecretFlagType)setting.value(secret + QLatin1String("-flags")).toInt();
-                            if (secretFlag == NetworkManager::Setting::None || secretFlag == NetworkManager::Setting::AgentOwned) {
-                                requestSecrets = true;
-                            }
-                        } else {
-                            requestSecrets = true;
+            Q_FOREACH (NetworkManager::Setting::SettingType type, secretSettings) {
+                const QString settingName = NetworkManager::Setting::typeAsString(type);
+                // VPN plugins know best which secrets they need, always ask for them
+                if (type == NetworkManager::Setting::Vpn) {
+                    requestSecrets(connection, settingName);
+                    continue;
+                }
+
+                NetworkManager::Setting::Ptr setting = connection->settings()->setting(type);
+                if (!setting) {
+                    continue;
+                }
+
+                QStringList requiredSecrets = setting->needSecrets();
+                if (type == NetworkManager::Setting::Security8021x && m_connection->connectionType() == NetworkManager::ConnectionSettings::Wireless) {
+                    requiredSecrets.removeAll(NM_SETTING_802_1X_PASSWORD_RAW);
+                }
+
+                // Secrets which are not saved or are only kept by NetworkManager itself are not worth asking for
+                const QVariantMap map = setting->toMap();
+                Q_FOREACH (const QString &secret, requiredSecrets) {
+                    if (map.contains(secret + QLatin1String("-flags"))) {
+                        NetworkManager::Setting::SecretFlagType secretFlag = (NetworkManager::Setting::SecretFlagType)map.value(secret + QLatin1String("-flags")).toInt();
+                        if (secretFlag != NetworkManager::Setting::None && secretFlag != NetworkManager::Setting::AgentOwned) {
+                            continue;
                         }
                     }
+                    requestSecrets(connection, settingName);
+                    break;
                 }
+            }
 
-                if (requestSecrets) {
-                    m_pendingReplies++;
-                    reply = connection->secrets(settingName);
-                    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
-                    watcher->setProperty("connection", connection->name());
-                    watcher->setProperty("settingName", settingName);
-                    connect(watcher, &QDBusPendingCallWatcher::finished, this, &ConnectionEditorBase::replyFinished);
-                    m_valid = false;
-                    Q_EMIT validityChanged(false);
-                    return;
-                }
+            // Widgets stay editable, the connection just can't be saved until secrets are loaded
+            if (!m_pendingReplies.isEmpty()) {
+                m_valid = false;
+                Q_EMIT validityChanged(false);
+                return;
             }
         }
     }
 
     // We should be now fully initialized as we don't wait for secrets
-    if (m_pendingReplies == 0) {
-        m_initialized = true;
+    m_initialized = true;
+    if (!emptyConnection) {
+        m_savedSettings = m_connection->toMap();
+    }
+}
+
+void ConnectionEditorBase::requestSecrets(const NetworkManager::Connection::Ptr &connection, const QString &settingName)
+{
+    QDBusPendingReply<NMVariantMapMap> reply = connection->secrets(settingName);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
+    watcher->setProperty("connection", connection->name());
+    watcher->setProperty("settingName", settingName);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &ConnectionEditorBase::replyFinished);
+    m_pendingReplies << watcher;
+}
+
+void ConnectionEditorBase::loadSecrets(SettingWidget *widget, const QString &settingName)
+{
+    const QString type = widget->type();
+    if (type == settingName ||
+            (settingName == NetworkManager::Setting::typeAsString(NetworkManager::Setting::Security8021x) &&
+             type == NetworkManager::Setting::typeAsString(NetworkManager::Setting::WirelessSecurity))) {
+        widget->loadSecrets(m_connection->setting(NetworkManager::Setting::typeFromString(settingName)));
     }
 }
 
 void ConnectionEditorBase::replyFinished(QDBusPendingCallWatcher *watcher)
 {
+    watcher->deleteLater();
+    if (!m_pendingReplies.removeOne(watcher)) {
+        return;
+    }
+
     QDBusPendingReply<NMVariantMapMap> reply = *watcher;
     const QString settingName = watcher->property("settingName").toString();
     if (reply.isValid()) {
         NMVariantMapMap secrets = reply.argumentAt<0>();
-        Q_FOREACH (const QString &key, secrets.keys()) {
-            if (key == settingName) {
-                NetworkManager::Setting::Ptr setting = m_connection->setting(NetworkManager::Setting::typeFromString(key));
-                if (setting) {
-                    setting->secretsFromMap(secrets.value(key));
-                    Q_FOREACH (SettingWidget *widget, m_settingWidgets) {
-                        const QString type = widget->type();
-                        if (type == settingName ||
-                                (settingName == NetworkManager::Setting::typeAsString(NetworkManager::Setting::Security8021x) &&
-                                 type == NetworkManager::Setting::typeAsString(NetworkManager::Setting::WirelessSecurity))) {
-                            widget->loadSecrets(setting);
-                        }
-                    }
+        if (secrets.contains(settingName)) {
+            NetworkManager::Setting::Ptr setting = m_connection->setting(NetworkManager::Setting::typeFromString(settingName));
+            if (setting) {
+                setting->secretsFromMap(secrets.value(settingName));
+                m_loadedSecrets << settingName;
+                Q_FOREACH (SettingWidget *widget, m_settingWidgets) {
+                    loadSecrets(widget, settingName);
                 }
             }
         }
@@ -453,12 +635,12 @@ void ConnectionEditorBase::replyFinished(QDBusPendingCallWatcher *watcher)
         notification->sendEvent();
     }
 
-    watcher->deleteLater();
-    validChanged(true);
-
     // We should be now fully with secrets
-    m_pendingReplies--;
-    m_initialized = true;
+    if (m_pendingReplies.isEmpty()) {
+        m_initialized = true;
+        m_savedSettings = m_connection->toMap();
+        validChanged(true);
+    }
 }
 
 void ConnectionEditorBase::validChanged(bool valid)
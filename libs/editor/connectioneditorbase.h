@@ -24,6 +24,9 @@
 #include <QDBusPendingCallWatcher>
 #include <QWidget>
 
+#include <functional>
+
+#include <NetworkManagerQt/Connection>
 #include <NetworkManagerQt/ConnectionSettings>
 
 class ConnectionWidget;
@@ -43,6 +46,12 @@ public:
 
     NMVariantMapMap setting() const;
 
+    // Returns settings which differ from the saved connection, see UiUtils::changedSettings()
+    NMVariantMapMap changedSettings(const NMVariantMapMap &settings) const;
+
+    // Remembers settings as the saved state of the connection, call after the connection was updated
+    void setSavedSetting(const NMVariantMapMap &settings);
+
     // Returns whether the editor is fully initialized (including secrets)
     bool isInitialized() const;
 
@@ -72,15 +81,43 @@ protected:
     void initialize();
 
 private:
+    // Tab whose setting widget is created the first time the tab is shown
+    struct LazyTab {
+        QWidget *placeholder;
+        QString type;
+        std::function<QWidget *()> factory;
+        bool materialized;
+    };
+
     bool m_initialized;
     bool m_valid;
-    int m_pendingReplies;
+    // Secrets requests which didn't finish yet, one per setting
+    QList<QDBusPendingCallWatcher *> m_pendingReplies;
     NetworkManager::ConnectionSettings::Ptr m_connection;
     ConnectionWidget *m_connectionWidget;
     QList<SettingWidget *> m_settingWidgets;
+    QList<LazyTab> m_lazyTabs;
+    // Settings whose secrets were already loaded into m_connection
+    QStringList m_loadedSecrets;
+    // Settings including secrets as they were loaded, empty until the editor is initialized
+    NMVariantMapMap m_savedSettings;
 
     void addConnectionWidget(ConnectionWidget *widget, const QString &text);
     void addSettingWidget(SettingWidget *widget, const QString &text);
+    /**
+     * @brief addLazyWidget adds a tab whose widget is created by factory when first shown,
+     * until then the setting is taken from the connection settings
+     * @param type name of the setting edited by the widget
+     */
+    void addLazyWidget(const QString &type, const QString &text, const std::function<QWidget *()> &factory);
+    void materialize(QWidget *placeholder);
+    void connectWifiWidgets();
+    void loadSecrets(SettingWidget *widget, const QString &settingName);
+    /**
+     * @brief requestSecrets asks for secrets of one setting, replies are handled
+     * independently so several settings can be requested at the same time
+     */
+    void requestSecrets(const NetworkManager::Connection::Ptr &connection, const QString &settingName);
 
 };
 
@@ -61,6 +61,11 @@ NMVariantMapMap ConnectionEditorDialog::setting() const
     return m_connectionEditorTabWidget->setting();
 }
 
+NMVariantMapMap ConnectionEditorDialog::changedSettings(const NMVariantMapMap &settings) const
+{
+    return m_connectionEditorTabWidget->changedSettings(settings);
+}
+
 void ConnectionEditorDialog::onValidityChanged(bool valid)
 {
     m_buttonBox->button(QDialogButtonBox::Save)->setEnabled(valid);
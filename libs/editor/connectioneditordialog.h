@@ -36,6 +36,7 @@ public:
     virtual ~ConnectionEditorDialog();
 
     NMVariantMapMap setting() const;
+    NMVariantMapMap changedSettings(const NMVariantMapMap &settings) const;
 
 private Q_SLOTS:
     void onValidityChanged(bool valid);
@@ -21,59 +21,376 @@
 #include "debug.h"
 #include "mobileproviders.h"
 
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QTextStream>
+#include <QXmlStreamReader>
 
 #include <KLocale>
 
+// Bump when the format of the index changes
+#define PROVIDERS_INDEX_MAGIC 0x504e4d50
+#define PROVIDERS_INDEX_VERSION 1
+
 const QString MobileProviders::ProvidersFile = "/usr/share/mobile-broadband-provider-info/serviceproviders.xml";
 
 bool localeAwareCompare(const QString & one, const QString & two) {
     return one.localeAwareCompare(two) < 0;
 }
 
+QDataStream &operator<<(QDataStream &stream, const MobileProviders::Apn &apn)
+{
+    stream << apn.value << apn.names << apn.username << apn.password << apn.dnsList;
+    return stream;
+}
+
+QDataStream &operator>>(QDataStream &stream, MobileProviders::Apn &apn)
+{
+    stream >> apn.value >> apn.names >> apn.username >> apn.password >> apn.dnsList;
+    return stream;
+}
+
+QDataStream &operator<<(QDataStream &stream, const MobileProviders::Provider &provider)
+{
+    stream << provider.names << provider.hasGsm << provider.hasCdma << provider.apns << provider.networkIds
+           << provider.cdmaUsername << provider.cdmaPassword << provider.sidList;
+    return stream;
+}
+
+QDataStream &operator>>(QDataStream &stream, MobileProviders::Provider &provider)
+{
+    stream >> provider.names >> provider.hasGsm >> provider.hasCdma >> provider.apns >> provider.networkIds
+           >> provider.cdmaUsername >> provider.cdmaPassword >> provider.sidList;
+    return stream;
+}
+
+static QString languageFromAttribute(const QXmlStreamReader &reader)
+{
+    QString lang = reader.attributes().value(QLatin1String("xml:lang")).toString();
+    if (lang.isEmpty()) {
+        lang = "en";     // English is default
+    } else {
+        lang = lang.toLower();
+        lang.remove(QRegExp("\\-.*$"));  // Remove everything after '-' in xml:lang attribute.
+    }
+    return lang;
+}
+
+// All readers below expect the reader to be at the start element and leave it at its end element
+
+static MobileProviders::Apn readApn(QXmlStreamReader &reader, bool *isInternet)
+{
+    MobileProviders::Apn apn;
+    apn.value = reader.attributes().value(QLatin1String("value")).toString();
+    *isInternet = true;
+
+    while (reader.readNextStartElement()) {
+        const QString tagName = reader.name().toString().toLower();
+        if (tagName == "usage") {
+            const QStringRef type = reader.attributes().value(QLatin1String("type"));
+            if (!type.isNull() && type.toString().toLower() != "internet") {
+                *isInternet = false;
+            }
+            reader.skipCurrentElement();
+        } else if (tagName == "name") {
+            const QString lang = languageFromAttribute(reader);
+            apn.names.insert(lang, reader.readElementText());
+        } else if (tagName == "username") {
+            apn.username = reader.readElementText();
+        } else if (tagName == "password") {
+            apn.password = reader.readElementText();
+        } else if (tagName == "dns") {
+            apn.dnsList.append(reader.readElementText());
+        } else {
+            reader.skipCurrentElement();
+        }
+    }
+
+    return apn;
+}
+
+static MobileProviders::Provider readProvider(QXmlStreamReader &reader)
+{
+    MobileProviders::Provider provider;
+
+    while (reader.readNextStartElement()) {
+        const QString tagName = reader.name().toString().toLower(); // <name | gsm | cdma>
+        if (tagName == "gsm") {
+            provider.hasGsm = true;
+            while (reader.readNextStartElement()) {
+                const QString gsmTagName = reader.name().toString().toLower(); // <apn | network-id>
+                if (gsmTagName == "apn") {
+                    bool isInternet;
+                    const MobileProviders::Apn apn = readApn(reader, &isInternet);
+                    if (isInternet) {
+                        provider.apns.append(apn);
+                    }
+                } else if (gsmTagName == "network-id") {
+                    provider.networkIds.append(reader.attributes().value(QLatin1String("mcc")).toString() + '-' +
+                                               reader.attributes().value(QLatin1String("mnc")).toString());
+                    reader.skipCurrentElement();
+                } else {
+                    reader.skipCurrentElement();
+                }
+            }
+        } else if (tagName == "cdma") {
+            provider.hasCdma = true;
+            while (reader.readNextStartElement()) {
+                const QString cdmaTagName = reader.name().toString().toLower(); // <name | username | password | sid>
+                if (cdmaTagName == "username") {
+                    provider.cdmaUsername = reader.readElementText();
+                } else if (cdmaTagName == "password") {
+                    provider.cdmaPassword = reader.readElementText();
+                } else if (cdmaTagName == "sid") {
+                    provider.sidList.append(reader.readElementText());
+                } else {
+                    reader.skipCurrentElement();
+                }
+            }
+        } else if (tagName == "name") {
+            const QString lang = languageFromAttribute(reader);
+            provider.names.insert(lang, reader.readElementText());
+        } else {
+            reader.skipCurrentElement();
+        }
+    }
+
+    return provider;
+}
+
+static QList<MobileProviders::Provider> readCountry(QXmlStreamReader &reader)
+{
+    QList<MobileProviders::Provider> providers;
+
+    while (reader.readNextStartElement()) {
+        if (reader.name().toString().toLower() == "provider") {
+            providers << readProvider(reader);
+        } else {
+            reader.skipCurrentElement();
+        }
+    }
+
+    return providers;
+}
+
 MobileProviders::MobileProviders()
+    : mIndex(0)
+    , mIndexData(0)
+    , mIndexDataStart(0)
+    , mProvidersXml(0)
+    , mProvidersXmlData(0)
+    , mError(Success)
+{
+    if (!openIndex()) {
+        buildIndex();
+    }
+}
+
+MobileProviders::~MobileProviders()
+{
+    delete mIndex;
+    delete mProvidersXml;
+}
+
+QString MobileProviders::indexFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/plasma-nm/serviceproviders.index");
+}
+
+bool MobileProviders::openIndex()
+{
+    const QFileInfo providersInfo(ProvidersFile);
+    if (!providersInfo.exists()) {
+        return false;
+    }
+
+    QFile *index = new QFile(indexFile());
+    if (!index->open(QIODevice::ReadOnly)) {
+        delete index;
+        return false;
+    }
+
+    const uchar *data = index->map(0, index->size());
+    if (!data) {
+        delete index;
+        return false;
+    }
+
+    const QByteArray rawData = QByteArray::fromRawData(reinterpret_cast<const char*>(data), index->size());
+    QDataStream stream(rawData);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    qint64 modified, size;
+    QString language;
+    stream >> magic >> version >> modified >> size >> language;
+    if (stream.status() != QDataStream::Ok || magic != PROVIDERS_INDEX_MAGIC || version != PROVIDERS_INDEX_VERSION ||
+        modified != providersInfo.lastModified().toMSecsSinceEpoch() || size != providersInfo.size() ||
+        language != KLocale::global()->language()) {
+        qCDebug(PLASMA_NM) << "Mobile providers index is outdated";
+        delete index;
+        return false;
+    }
+
+    stream >> mCountries >> mCountryOffsets;
+    if (stream.status() != QDataStream::Ok) {
+        mCountries.clear();
+        mCountryOffsets.clear();
+        delete index;
+        return false;
+    }
+
+    mIndex = index;
+    mIndexData = data;
+    mIndexDataStart = stream.device()->pos();
+    return true;
+}
+
+void MobileProviders::buildIndex()
 {
     const QStringList allCountries = KLocale::global()->allCountriesList();
     Q_FOREACH (const QString & cc, allCountries) {
         // qCDebug(PLASMA_NM) << "Inserting" << cc.toUpper() << KLocale::global()->countryCodeToName(cc);
         mCountries.insert(cc.toUpper(), KLocale::global()->countryCodeToName(cc));
     }
-    mError = Success;
 
     QFile file2(ProvidersFile);
+    if (!file2.open(QIODevice::ReadOnly)) {
+        qCWarning(PLASMA_NM) << "Error opening providers file" << ProvidersFile;
+        mError = ProvidersMissing;
+        return;
+    }
 
-    if (file2.open(QIODevice::ReadOnly)) {
-        if (mDocProviders.setContent(&file2)) {
-            docElement = mDocProviders.documentElement();
-
-            if (docElement.isNull()) {
-                qCWarning(PLASMA_NM) << ProvidersFile << ": document is null";
-                mError = ProvidersIsNull;
-            } else {
-                if (docElement.isNull() || docElement.tagName() != "serviceproviders") {
-                    qCWarning(PLASMA_NM) << ProvidersFile << ": wrong format";
-                    mError = ProvidersWrongFormat;
-                } else {
-                    if (docElement.attribute("format") != "2.0") {
-                        qCWarning(PLASMA_NM) << ProvidersFile << ": mobile broadband provider database format '" << docElement.attribute("format") << "' not supported.";
-                        mError = ProvidersFormatNotSupported;
-                    } else {
-                        // qCDebug(PLASMA_NM) << "Everything is alright so far";
-                    }
-                }
+    // Countries are streamed one after another, their offsets go to the header
+    QByteArray data;
+    QDataStream dataStream(&data, QIODevice::WriteOnly);
+    dataStream.setVersion(QDataStream::Qt_5_0);
+    QHash<QString, quint64> offsets;
+
+    // Single forward pass, only the providers of one country are in memory at a time
+    QXmlStreamReader reader(&file2);
+    if (!reader.readNextStartElement()) {
+        qCWarning(PLASMA_NM) << ProvidersFile << ": document is null";
+        mError = ProvidersIsNull;
+        return;
+    } else if (reader.name() != QLatin1String("serviceproviders")) {
+        qCWarning(PLASMA_NM) << ProvidersFile << ": wrong format";
+        mError = ProvidersWrongFormat;
+        return;
+    } else if (reader.attributes().value(QLatin1String("format")) != QLatin1String("2.0")) {
+        qCWarning(PLASMA_NM) << ProvidersFile << ": mobile broadband provider database format '" << reader.attributes().value(QLatin1String("format")) << "' not supported.";
+        mError = ProvidersFormatNotSupported;
+        return;
+    }
+
+    while (reader.readNextStartElement()) {
+        if (reader.name() == QLatin1String("country")) {
+            offsets.insert(reader.attributes().value(QLatin1String("code")).toString().toUpper(), dataStream.device()->pos());
+            dataStream << readCountry(reader);
+        } else {
+            reader.skipCurrentElement();
+        }
+    }
+
+    if (reader.hasError()) {
+        qCWarning(PLASMA_NM) << ProvidersFile << ":" << reader.errorString();
+        mError = ProvidersWrongFormat;
+        return;
+    }
+    file2.close();
+
+    const QFileInfo providersInfo(ProvidersFile);
+    QDir().mkpath(QFileInfo(indexFile()).absolutePath());
+    QSaveFile index(indexFile());
+    if (index.open(QIODevice::WriteOnly)) {
+        QDataStream stream(&index);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << (quint32) PROVIDERS_INDEX_MAGIC << (quint32) PROVIDERS_INDEX_VERSION
+               << providersInfo.lastModified().toMSecsSinceEpoch() << providersInfo.size()
+               << KLocale::global()->language() << mCountries << offsets;
+        stream.writeRawData(data.constData(), data.size());
+        if (index.commit()) {
+            const QHash<QString, QString> countries = mCountries;
+            mCountries.clear();
+            if (openIndex()) {
+                return;
             }
+            mCountries = countries;
         }
+    }
 
-        file2.close();
-    } else {
-        qCWarning(PLASMA_NM) << "Error opening providers file" << ProvidersFile;
-        mError = ProvidersMissing;
+    qCDebug(PLASMA_NM) << "Cannot use mobile providers index, reading" << ProvidersFile << "on demand";
+    scanProviders();
+}
+
+void MobileProviders::scanProviders()
+{
+    QFile *providersXml = new QFile(ProvidersFile);
+    if (!providersXml->open(QIODevice::ReadOnly)) {
+        delete providersXml;
+        return;
+    }
+
+    const uchar *data = providersXml->map(0, providersXml->size());
+    if (!data) {
+        delete providersXml;
+        return;
+    }
+
+    const QByteArray rawData = QByteArray::fromRawData(reinterpret_cast<const char*>(data), providersXml->size());
+
+    // The reader gives character offsets only, so find the start tags of the countries
+    // in the raw data in the same order the reader reports them
+    QXmlStreamReader reader(rawData);
+    int position = 0;
+    if (reader.readNextStartElement()) {
+        while (reader.readNextStartElement()) {
+            if (reader.name() == QLatin1String("country")) {
+                position = rawData.indexOf("<country", position);
+                if (position < 0) {
+                    break;
+                }
+                mXmlCountryOffsets.insert(reader.attributes().value(QLatin1String("code")).toString().toUpper(), position);
+                ++position;
+            }
+            reader.skipCurrentElement();
+        }
     }
+
+    mProvidersXml = providersXml;
+    mProvidersXmlData = data;
 }
 
-MobileProviders::~MobileProviders()
+QList<MobileProviders::Provider> MobileProviders::loadCountry(const QString & countryCode)
 {
+    QList<Provider> providers;
+
+    if (mIndexData) {
+        if (!mCountryOffsets.contains(countryCode)) {
+            return providers;
+        }
+
+        const QByteArray rawData = QByteArray::fromRawData(reinterpret_cast<const char*>(mIndexData), mIndex->size());
+        QDataStream stream(rawData);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream.device()->seek(mIndexDataStart + mCountryOffsets.value(countryCode));
+        stream >> providers;
+    } else if (mProvidersXmlData && mXmlCountryOffsets.contains(countryCode)) {
+        // Parse just the subtree of the country
+        const qint64 offset = mXmlCountryOffsets.value(countryCode);
+        const QByteArray rawData = QByteArray::fromRawData(reinterpret_cast<const char*>(mProvidersXmlData) + offset, mProvidersXml->size() - offset);
+        QXmlStreamReader reader(rawData);
+        if (reader.readNextStartElement() && reader.name() == QLatin1String("country")) {
+            providers = readCountry(reader);
+        }
+    }
+
+    return providers;
 }
 
 QStringList MobileProviders::getCountryList() const
@@ -92,7 +409,6 @@ QStringList MobileProviders::getProvidersList(QString country, NetworkManager::C
 {
     mProvidersGsm.clear();
     mProvidersCdma.clear();
-    QDomNode n = docElement.firstChild();
 
     // country is a country name and we parse country codes.
     if (!mCountries.key(country).isNull()) {
@@ -100,56 +416,16 @@ QStringList MobileProviders::getProvidersList(QString country, NetworkManager::C
     }
     QMap<QString, QString> sortedGsm;
     QMap<QString, QString> sortedCdma;
-    while (!n.isNull()) {
-        QDomElement e = n.toElement(); // <country ...>
-
-        if (!e.isNull() && e.attribute("code").toUpper() == country) {
-            QDomNode n2 = e.firstChild();
-            while (!n2.isNull()) {
-                QDomElement e2 = n2.toElement(); // <provider ...>
-
-                if (!e2.isNull() && e2.tagName().toLower() == "provider") {
-                    QDomNode n3 = e2.firstChild();
-                    bool hasGsm = false;
-                    bool hasCdma = false;
-                    QMap<QString, QString> localizedProviderNames;
-
-                    while (!n3.isNull()) {
-                        QDomElement e3 = n3.toElement(); // <name | gsm | cdma>
-
-                        if (!e3.isNull()) {
-                            if (e3.tagName().toLower() == "gsm") {
-                                hasGsm = true;
-                            } else if (e3.tagName().toLower() == "cdma") {
-                                hasCdma = true;
-                            } else if (e3.tagName().toLower() == "name") {
-                                QString lang = e3.attribute("xml:lang");
-                                if (lang.isEmpty()) {
-                                    lang = "en";     // English is default
-                                } else {
-                                    lang = lang.toLower();
-                                    lang.remove(QRegExp("\\-.*$"));  // Remove everything after '-' in xml:lang attribute.
-                                }
-                                localizedProviderNames.insert(lang, e3.text());
-                            }
-                        }
-                        n3 = n3.nextSibling();
-                    }
-                    const QString name = getNameByLocale(localizedProviderNames);
-                    if (hasGsm) {
-                        mProvidersGsm.insert(name, e2.firstChild());
-                        sortedGsm.insert(name.toLower(), name);
-                    }
-                    if (hasCdma) {
-                        mProvidersCdma.insert(name, e2.firstChild());
-                        sortedCdma.insert(name.toLower(), name);
-                    }
-                }
-                n2 = n2.nextSibling();
-            }
-            break;
+    Q_FOREACH (const Provider & provider, loadCountry(country)) {
+        const QString name = getNameByLocale(provider.names);
+        if (provider.hasGsm) {
+            mProvidersGsm.insert(name, provider);
+            sortedGsm.insert(name.toLower(), name);
+        }
+        if (provider.hasCdma) {
+            mProvidersCdma.insert(name, provider);
+            sortedCdma.insert(name.toLower(), name);
         }
-        n = n.nextSibling();
     }
 
     if (type == NetworkManager::ConnectionSettings::Gsm) {
@@ -166,43 +442,11 @@ QStringList MobileProviders::getApns(const QString & provider)
         return QStringList();
     }
 
-    QDomNode n = mProvidersGsm[provider];
-
-    while (!n.isNull()) {
-        QDomElement e = n.toElement(); // <gsm | cdma>
-
-        if (!e.isNull() && e.tagName().toLower() == "gsm") {
-            QDomNode n2 = e.firstChild();
-            while (!n2.isNull()) {
-                QDomElement e2 = n2.toElement(); // <apn | network-id>
-
-                if (!e2.isNull() && e2.tagName().toLower() == "apn") {
-                    bool isInternet = true;
-                    QDomNode n3 = e2.firstChild();
-                    while (!n3.isNull()) {
-                        QDomElement e3 = n3.toElement(); // <usage>
-                        if (!e3.isNull() &&
-                            e3.tagName().toLower() == "usage" &&
-                            !e3.attribute("type").isNull() &&
-                            e3.attribute("type").toLower() != "internet") {
-                            // qCDebug(PLASMA_NM) << "apn" << e2.attribute("value") << "ignored because of usage" << e3.attribute("type");
-                            isInternet = false;
-                            break;
-                        }
-                        n3 = n3.nextSibling();
-                    }
-                    if (isInternet) {
-                        mApns.insert(e2.attribute("value"), e2.firstChild());
-                    }
-                } else if (!e2.isNull() && e2.tagName().toLower() == "network-id") {
-                    mNetworkIds.append(e2.attribute("mcc") + '-' + e2.attribute("mnc"));
-                }
-
-                n2 = n2.nextSibling();
-            }
-        }
-        n = n.nextSibling();
+    const Provider gsmProvider = mProvidersGsm.value(provider);
+    Q_FOREACH (const Apn & apn, gsmProvider.apns) {
+        mApns.insert(apn.value, apn);
     }
+    mNetworkIds = gsmProvider.networkIds;
 
     QStringList temp = mApns.keys();
     temp.sort();
@@ -221,42 +465,22 @@ QStringList MobileProviders::getNetworkIds(const QString & provider)
 QVariantMap MobileProviders::getApnInfo(const QString & apn)
 {
     QVariantMap temp;
-    QDomNode n = mApns[apn];
-    QStringList dnsList;
-    QMap<QString, QString> localizedPlanNames;
-
-    while (!n.isNull()) {
-        QDomElement e = n.toElement(); // <name|username|password|dns(*)>
-
-        if (!e.isNull()) {
-            if (e.tagName().toLower() == "name") {
-                QString lang = e.attribute("xml:lang");
-                if (lang.isEmpty()) {
-                    lang = "en";     // English is default
-                } else {
-                    lang = lang.toLower();
-                    lang.remove(QRegExp("\\-.*$"));  // Remove everything after '-' in xml:lang attribute.
-                }
-                localizedPlanNames.insert(lang, e.text());
-            } else if (e.tagName().toLower() == "username") {
-                temp.insert("username", e.text());
-            } else if (e.tagName().toLower() == "password") {
-                temp.insert("password", e.text());
-            } else if (e.tagName().toLower() == "dns") {
-                dnsList.append(e.text());
-            }
-        }
+    const Apn apnInfo = mApns.value(apn);
 
-        n = n.nextSibling();
+    if (!apnInfo.username.isEmpty()) {
+        temp.insert("username", apnInfo.username);
+    }
+    if (!apnInfo.password.isEmpty()) {
+        temp.insert("password", apnInfo.password);
     }
 
-    QString name = getNameByLocale(localizedPlanNames);
+    QString name = getNameByLocale(apnInfo.names);
     if (!name.isEmpty()) {
         temp.insert("name", QVariant::fromValue(name));
     }
     temp.insert("number", getGsmNumber());
     temp.insert("apn", apn);
-    temp.insert("dnsList", dnsList);
+    temp.insert("dnsList", apnInfo.dnsList);
 
     return temp;
 }
@@ -268,35 +492,16 @@ QVariantMap MobileProviders::getCdmaInfo(const QString & provider)
     }
 
     QVariantMap temp;
-    QDomNode n = mProvidersCdma[provider];
-    QStringList sidList;
-
-    while (!n.isNull()) {
-        QDomElement e = n.toElement(); // <gsm or cdma ...>
-
-        if (!e.isNull() && e.tagName().toLower() == "cdma") {
-            QDomNode n2 = e.firstChild();
-            while (!n2.isNull()) {
-                QDomElement e2 = n2.toElement(); // <name | username | password | sid>
-
-                if (!e2.isNull()) {
-                    if (e2.tagName().toLower() == "username") {
-                        temp.insert("username", e2.text());
-                    } else if (e2.tagName().toLower() == "password") {
-                        temp.insert("password", e2.text());
-                    } else if (e2.tagName().toLower() == "sid") {
-                        sidList.append(e2.text());
-                    }
-                }
+    const Provider cdmaProvider = mProvidersCdma.value(provider);
 
-                n2 = n2.nextSibling();
-            }
-        }
-        n = n.nextSibling();
+    if (!cdmaProvider.cdmaUsername.isEmpty()) {
+        temp.insert("username", cdmaProvider.cdmaUsername);
+    }
+    if (!cdmaProvider.cdmaPassword.isEmpty()) {
+        temp.insert("password", cdmaProvider.cdmaPassword);
     }
-
     temp.insert("number", getCdmaNumber());
-    temp.insert("sidList", sidList);
+    temp.insert("sidList", cdmaProvider.sidList);
     return temp;
 }
 
@@ -23,11 +23,12 @@
 
 #include <QStringList>
 #include <QHash>
-#include <QDomDocument>
 #include <QVariantMap>
 
 #include <NetworkManagerQt/ConnectionSettings>
 
+class QFile;
+
 class MobileProviders
 {
 public:
@@ -35,6 +36,26 @@ public:
 
     enum ErrorCodes { Success, CountryCodesMissing, ProvidersMissing, ProvidersIsNull, ProvidersWrongFormat, ProvidersFormatNotSupported };
 
+    struct Apn {
+        QString value;
+        // Localized plan names by language
+        QMap<QString, QString> names;
+        QString username;
+        QString password;
+        QStringList dnsList;
+    };
+
+    struct Provider {
+        QMap<QString, QString> names;
+        bool hasGsm = false;
+        bool hasCdma = false;
+        QList<Apn> apns;
+        QStringList networkIds;
+        QString cdmaUsername;
+        QString cdmaPassword;
+        QStringList sidList;
+    };
+
     MobileProviders();
     ~MobileProviders();
 
@@ -51,13 +72,37 @@ public:
     inline ErrorCodes getError() { return mError; }
 
 private:
+    /**
+     * @brief openIndex maps the binary index of the providers database
+     * @return false if there is no index or it is older than the database
+     */
+    bool openIndex();
+    /**
+     * @brief buildIndex parses the providers database and writes the binary index
+     */
+    void buildIndex();
+    /**
+     * @brief scanProviders records where each country starts in the providers database,
+     * used instead of the index when it can't be written
+     */
+    void scanProviders();
+    QList<Provider> loadCountry(const QString & countryCode);
+    static QString indexFile();
+
     QHash<QString, QString> mCountries;
-    QMap<QString, QDomNode> mProvidersGsm;
-    QMap<QString, QDomNode> mProvidersCdma;
-    QMap<QString, QDomNode> mApns;
+    QHash<QString, Provider> mProvidersGsm;
+    QHash<QString, Provider> mProvidersCdma;
+    QHash<QString, Apn> mApns;
     QStringList mNetworkIds;
-    QDomDocument mDocProviders;
-    QDomElement docElement;
+    // Offsets of countries in the data section of the index
+    QHash<QString, quint64> mCountryOffsets;
+    QFile *mIndex;
+    const uchar *mIndexData;
+    qint64 mIndexDataStart;
+    // Used only when the index could not be written
+    QFile *mProvidersXml;
+    const uchar *mProvidersXmlData;
+    QHash<QString, qint64> mXmlCountryOffsets;
     ErrorCodes mError;
     QString getNameByLocale(const QMap<QString, QString> & names) const;
 };
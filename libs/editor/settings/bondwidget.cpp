@@ -22,6 +22,7 @@
 #include "ui_bond.h"
 #include "connectioneditordialog.h"
 #include "debug.h"
+#include "slaveconnectionindex.h"
 
 #include <QDBusPendingReply>
 
@@ -70,6 +71,7 @@ BondWidget::BondWidget(const QString & masterUuid, const NetworkManager::Setting
 
     // bonds
     populateBonds();
+    connect(SlaveConnectionIndex::self(), &SlaveConnectionIndex::slavesChanged, this, &BondWidget::slavesChanged);
     connect(m_ui->bonds, &QListWidget::currentItemChanged, this, &BondWidget::currentBondChanged);
     connect(m_ui->bonds, &QListWidget::itemDoubleClicked, this, &BondWidget::editBond);
 
@@ -212,9 +214,7 @@ void BondWidget::bondAddComplete(QDBusPendingCallWatcher * watcher)
         // find the slave connection with matching UUID
         NetworkManager::Connection::Ptr connection = NetworkManager::findConnection(reply.value().path());
         if (connection && connection->settings()->master() == m_uuid) {
-            const QString label = QString("%1 (%2)").arg(connection->name()).arg(connection->settings()->typeAsString(connection->settings()->connectionType()));
-            QListWidgetItem * slaveItem = new QListWidgetItem(label, m_ui->bonds);
-            slaveItem->setData(Qt::UserRole, connection->uuid());
+            populateBonds();
             slotWidgetChanged();
         }
     } else {
@@ -236,8 +236,10 @@ void BondWidget::editBond()
         QPointer<ConnectionEditorDialog> bondEditor = new ConnectionEditorDialog(connection->settings());
         connect(bondEditor.data(), &ConnectionEditorDialog::accepted,
                 [connection, bondEditor, this] () {
-                    connection->update(bondEditor->setting());
-                    connect(connection.data(), &NetworkManager::Connection::updated, this, &BondWidget::populateBonds);
+                    const NMVariantMapMap settings = bondEditor->setting();
+                    if (!bondEditor->changedSettings(settings).isEmpty()) {
+                        connection->update(settings);
+                    }
                 });
         connect(bondEditor.data(), &ConnectionEditorDialog::finished,
                 [bondEditor] () {
@@ -275,13 +277,18 @@ void BondWidget::populateBonds()
 {
     m_ui->bonds->clear();
 
-    Q_FOREACH (const NetworkManager::Connection::Ptr &connection, NetworkManager::listConnections()) {
-        NetworkManager::ConnectionSettings::Ptr settings = connection->settings();
-        if (settings->master() == m_uuid && settings->slaveType() == type()) {
-            const QString label = QString("%1 (%2)").arg(connection->name()).arg(connection->settings()->typeAsString(connection->settings()->connectionType()));
-            QListWidgetItem * slaveItem = new QListWidgetItem(label, m_ui->bonds);
-            slaveItem->setData(Qt::UserRole, connection->uuid());
-        }
+    Q_FOREACH (const NetworkManager::Connection::Ptr &connection, SlaveConnectionIndex::self()->slaves(m_uuid, type())) {
+        const QString label = QString("%1 (%2)").arg(connection->name()).arg(connection->settings()->typeAsString(connection->settings()->connectionType()));
+        QListWidgetItem * slaveItem = new QListWidgetItem(label, m_ui->bonds);
+        slaveItem->setData(Qt::UserRole, connection->uuid());
+    }
+}
+
+void BondWidget::slavesChanged(const QString &master)
+{
+    if (master == m_uuid) {
+        populateBonds();
+        slotWidgetChanged();
     }
 }
 
@@ -58,6 +58,7 @@ private Q_SLOTS:
     void deleteBond();
 
     void populateBonds();
+    void slavesChanged(const QString &master);
 
 private:
     QString m_uuid;
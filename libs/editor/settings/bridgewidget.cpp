@@ -22,6 +22,7 @@
 #include "ui_bridge.h"
 #include "connectioneditordialog.h"
 #include "debug.h"
+#include "slaveconnectionindex.h"
 
 #include <QDBusPendingReply>
 
@@ -58,6 +59,7 @@ BridgeWidget::BridgeWidget(const QString & masterUuid, const NetworkManager::Set
 
     // bridges
     populateBridges();
+    connect(SlaveConnectionIndex::self(), &SlaveConnectionIndex::slavesChanged, this, &BridgeWidget::slavesChanged);
     connect(m_ui->bridges, &QListWidget::currentItemChanged, this, &BridgeWidget::currentBridgeChanged);
     connect(m_ui->bridges, &QListWidget::itemDoubleClicked, this, &BridgeWidget::editBridge);
 
@@ -162,9 +164,7 @@ void BridgeWidget::bridgeAddComplete(QDBusPendingCallWatcher * watcher)
         // find the slave connection with matching UUID
         NetworkManager::Connection::Ptr connection = NetworkManager::findConnection(reply.value().path());
         if (connection && connection->settings()->master() == m_uuid) {
-            const QString label = QString("%1 (%2)").arg(connection->name()).arg(connection->settings()->typeAsString(connection->settings()->connectionType()));
-            QListWidgetItem * slaveItem = new QListWidgetItem(label, m_ui->bridges);
-            slaveItem->setData(Qt::UserRole, connection->uuid());
+            populateBridges();
             slotWidgetChanged();
         }
     } else {
@@ -186,8 +186,10 @@ void BridgeWidget::editBridge()
         QPointer<ConnectionEditorDialog> bridgeEditor = new ConnectionEditorDialog(connection->settings());
         connect(bridgeEditor.data(), &ConnectionEditorDialog::accepted,
                 [connection, bridgeEditor, this] () {
-                    connection->update(bridgeEditor->setting());
-                    connect(connection.data(), &NetworkManager::Connection::updated, this, &BridgeWidget::populateBridges);
+                    const NMVariantMapMap settings = bridgeEditor->setting();
+                    if (!bridgeEditor->changedSettings(settings).isEmpty()) {
+                        connection->update(settings);
+                    }
                 });
         connect(bridgeEditor.data(), &ConnectionEditorDialog::finished,
                 [bridgeEditor] () {
@@ -225,13 +227,18 @@ void BridgeWidget::populateBridges()
 {
     m_ui->bridges->clear();
 
-    Q_FOREACH (const NetworkManager::Connection::Ptr &connection, NetworkManager::listConnections()) {
-        NetworkManager::ConnectionSettings::Ptr settings = connection->settings();
-        if (settings->master() == m_uuid && settings->slaveType() == type()) {
-            const QString label = QString("%1 (%2)").arg(connection->name()).arg(connection->settings()->typeAsString(connection->settings()->connectionType()));
-            QListWidgetItem * slaveItem = new QListWidgetItem(label, m_ui->bridges);
-            slaveItem->setData(Qt::UserRole, connection->uuid());
-        }
+    Q_FOREACH (const NetworkManager::Connection::Ptr &connection, SlaveConnectionIndex::self()->slaves(m_uuid, type())) {
+        const QString label = QString("%1 (%2)").arg(connection->name()).arg(connection->settings()->typeAsString(connection->settings()->connectionType()));
+        QListWidgetItem * slaveItem = new QListWidgetItem(label, m_ui->bridges);
+        slaveItem->setData(Qt::UserRole, connection->uuid());
+    }
+}
+
+void BridgeWidget::slavesChanged(const QString &master)
+{
+    if (master == m_uuid) {
+        populateBridges();
+        slotWidgetChanged();
     }
 }
 
@@ -58,6 +58,7 @@ private Q_SLOTS:
     void deleteBridge();
 
     void populateBridges();
+    void slavesChanged(const QString &master);
 
 private:
     QString m_uuid;
@@ -21,6 +21,7 @@
 #include "ipv4widget.h"
 #include "ui_ipv4.h"
 #include "ipv4delegate.h"
+#include "simpleipv4addressvalidator.h"
 
 #include <QDialog>
 #include <QDialogButtonBox>
@@ -487,12 +488,8 @@ bool IPv4Widget::isValid() const
     }
 
     if (!m_ui->dns->text().isEmpty() && (m_ui->method->currentIndex() == Automatic || m_ui->method->currentIndex() == Manual || m_ui->method->currentIndex() == AutomaticOnlyIP)) {
-        const QStringList tmp = m_ui->dns->text().split(',');
-        Q_FOREACH (const QString & str, tmp) {
-            QHostAddress addr(str);
-            if (addr.isNull()) {
-                return false;
-            }
+        if (!SimpleIpV4AddressValidator::isValidList(m_ui->dns->text())) {
+            return false;
         }
     }
 
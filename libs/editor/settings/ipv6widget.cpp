@@ -21,6 +21,7 @@
 #include "ipv6widget.h"
 #include "ui_ipv6.h"
 #include "ipv6delegate.h"
+#include "simpleipv6addressvalidator.h"
 #include "intdelegate.h"
 
 #include <QDialog>
@@ -478,12 +479,8 @@ bool IPv6Widget::isValid() const
     }
 
     if (!m_ui->dns->text().isEmpty() && (m_ui->method->currentIndex() == Automatic || m_ui->method->currentIndex() == Manual || m_ui->method->currentIndex() == AutomaticOnlyIP)) {
-        const QStringList tmp = m_ui->dns->text().split(',');
-        Q_FOREACH (const QString & str, tmp) {
-            QHostAddress addr(str);
-            if (addr.isNull()) {
-                return false;
-            }
+        if (!SimpleIpV6AddressValidator::isValidList(m_ui->dns->text())) {
+            return false;
         }
     }
 
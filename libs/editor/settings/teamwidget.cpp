@@ -22,6 +22,7 @@
 #include "ui_team.h"
 #include "connectioneditordialog.h"
 #include "debug.h"
+#include "slaveconnectionindex.h"
 
 #include <QDesktopServices>
 #include <QFileDialog>
@@ -65,6 +66,7 @@ TeamWidget::TeamWidget(const QString & masterUuid, const NetworkManager::Setting
 
     // teams
     populateTeams();
+    connect(SlaveConnectionIndex::self(), &SlaveConnectionIndex::slavesChanged, this, &TeamWidget::slavesChanged);
     connect(m_ui->teams, &QListWidget::currentItemChanged, this, &TeamWidget::currentTeamChanged);
     connect(m_ui->teams, &QListWidget::itemDoubleClicked, this, &TeamWidget::editTeam);
 
@@ -151,9 +153,7 @@ void TeamWidget::teamAddComplete(QDBusPendingCallWatcher * watcher)
         // find the slave connection with matching UUID
         NetworkManager::Connection::Ptr connection = NetworkManager::findConnection(reply.value().path());
         if (connection && connection->settings()->master() == m_uuid) {
-            const QString label = QString("%1 (%2)").arg(connection->name()).arg(connection->settings()->typeAsString(connection->settings()->connectionType()));
-            QListWidgetItem * slaveItem = new QListWidgetItem(label, m_ui->teams);
-            slaveItem->setData(Qt::UserRole, connection->uuid());
+            populateTeams();
             slotWidgetChanged();
         }
     } else {
@@ -175,8 +175,10 @@ void TeamWidget::editTeam()
         QPointer<ConnectionEditorDialog> teamEditor = new ConnectionEditorDialog(connection->settings());
         connect(teamEditor.data(), &ConnectionEditorDialog::accepted,
                 [connection, teamEditor, this] () {
-                    connection->update(teamEditor->setting());
-                    connect(connection.data(), &NetworkManager::Connection::updated, this, &TeamWidget::populateTeams);
+                    const NMVariantMapMap settings = teamEditor->setting();
+                    if (!teamEditor->changedSettings(settings).isEmpty()) {
+                        connection->update(settings);
+                    }
                 });
         connect(teamEditor.data(), &ConnectionEditorDialog::finished,
                 [teamEditor] () {
@@ -214,13 +216,18 @@ void TeamWidget::populateTeams()
 {
     m_ui->teams->clear();
 
-    Q_FOREACH (const NetworkManager::Connection::Ptr &connection, NetworkManager::listConnections()) {
-        NetworkManager::ConnectionSettings::Ptr settings = connection->settings();
-        if (settings->master() == m_uuid && settings->slaveType() == type()) {
-            const QString label = QString("%1 (%2)").arg(connection->name()).arg(connection->settings()->typeAsString(connection->settings()->connectionType()));
-            QListWidgetItem * slaveItem = new QListWidgetItem(label, m_ui->teams);
-            slaveItem->setData(Qt::UserRole, connection->uuid());
-        }
+    Q_FOREACH (const NetworkManager::Connection::Ptr &connection, SlaveConnectionIndex::self()->slaves(m_uuid, type())) {
+        const QString label = QString("%1 (%2)").arg(connection->name()).arg(connection->settings()->typeAsString(connection->settings()->connectionType()));
+        QListWidgetItem * slaveItem = new QListWidgetItem(label, m_ui->teams);
+        slaveItem->setData(Qt::UserRole, connection->uuid());
+    }
+}
+
+void TeamWidget::slavesChanged(const QString &master)
+{
+    if (master == m_uuid) {
+        populateTeams();
+        slotWidgetChanged();
     }
 }
 
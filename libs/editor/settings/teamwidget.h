@@ -58,6 +58,7 @@ private Q_SLOTS:
     void deleteTeam();
 
     void populateTeams();
+    void slavesChanged(const QString &master);
 
     void importConfig();
 
@@ -20,11 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "simpleipv4addressvalidator.h"
 
-#include <QStringList>
-#include <QVector>
-
-SimpleIpV4AddressValidator::SimpleIpV4AddressValidator(QObject *parent)
+SimpleIpV4AddressValidator::SimpleIpV4AddressValidator(QObject *parent, AddressStyle style)
     : QValidator(parent)
+    , m_style(style)
 {
 }
 
@@ -34,66 +32,175 @@ SimpleIpV4AddressValidator::~SimpleIpV4AddressValidator()
 
 QValidator::State SimpleIpV4AddressValidator::validate(QString &address, int &pos) const
 {
-    if (QValidator::Invalid == checkWithInputMask(address, pos)) {
-        return QValidator::Invalid;
+    Q_UNUSED(pos)
+
+    const QValidator::State state = checkAddress(QStringRef(&address), m_style);
+    if (state == QValidator::Invalid) {
+        return state;
     }
 
-    // this list will be filled with tetrad values. It can be used to make
-    // some additional correctness checks on the last validation step.
-    QList<int> tetrads;
+    // correct tetrad values: for example, 001 -> 1
+    // The string is only touched when there is something to remove
+    const QChar *data = address.constData();
+    const int size = address.size();
+    for (int i = 0; i < size; ++i) {
+        if (data[i] == QLatin1Char('/')) {
+            break;
+        }
+        const bool groupStart = (i == 0 || data[i - 1] == QLatin1Char('.'));
+        if (groupStart && data[i] == QLatin1Char('0') && i + 1 < size && data[i + 1].isDigit()) {
+            int j = i;
+            while (j + 1 < size && data[j] == QLatin1Char('0') && data[j + 1].isDigit()) {
+                ++j;
+            }
+            address.remove(i, j - i);
+            return validate(address, pos);
+        }
+    }
 
-    return checkTetradsRanges(address, tetrads);
+    return state;
 }
 
 QValidator::State SimpleIpV4AddressValidator::checkWithInputMask(QString &value, int &pos) const
 {
-    QRegExpValidator v(QRegExp(QLatin1String("[0-9, ]{1,3}\\.[0-9, ]{1,3}\\.[0-9, ]{1,3}\\.[0-9, ]{1,3}")), 0);
+    Q_UNUSED(pos)
+
+    int groups = 1;
+    int groupLength = 0;
+    Q_FOREACH (const QChar &c, value) {
+        if (c == QLatin1Char('.')) {
+            if (groupLength == 0 || ++groups > 4) {
+                return QValidator::Invalid;
+            }
+            groupLength = 0;
+        } else if (c.isDigit()) {
+            if (++groupLength > 3) {
+                return QValidator::Invalid;
+            }
+        } else {
+            return QValidator::Invalid;
+        }
+    }
 
-    return v.validate(value, pos);
+    return (groups == 4 && groupLength > 0) ? QValidator::Acceptable : QValidator::Intermediate;
 }
 
 QValidator::State SimpleIpV4AddressValidator::checkTetradsRanges(QString &value, QList<int> &tetrads) const
 {
-    QStringList temp;
-    const QVector<QStringRef> addrParts = value.splitRef(QLatin1Char('.'));
-    int i = 0;
     // fill in the list with invalid values
     tetrads << -1 << -1 << -1 << -1;
 
-    // lets check address parts
-    Q_FOREACH (const QStringRef &part, addrParts) {
-        if (part.isEmpty()) {
-            if (i != (addrParts.size() - 1)) {
-                // qCDebug(PLASMA_NM) << "part.isEmpty()";
-                return QValidator::Invalid;
-            }
-            // the last tetrad can be empty, continue...
-            return QValidator::Intermediate;
+    const QValidator::State state = checkAddress(QStringRef(&value));
+    if (state == QValidator::Invalid) {
+        return state;
+    }
+
+    int i = 0;
+    Q_FOREACH (const QChar &c, value) {
+        if (c == QLatin1Char('.')) {
+            ++i;
+        } else {
+            tetrads[i] = qMax(tetrads[i], 0) * 10 + c.digitValue();
         }
+    }
 
-        tetrads[i] = part.toInt();
+    int pos = 0;
+    validate(value, pos);
+    return state;
+}
 
-        if (tetrads[i] > 255) {
-            // qCDebug(PLASMA_NM) << "tetrads[i] > 255";
+QValidator::State SimpleIpV4AddressValidator::checkAddress(const QStringRef &address, AddressStyle style, int *prefixLength)
+{
+    const QChar *data = address.unicode();
+    const int size = address.size();
+
+    int groups = 1;
+    int groupLength = 0;
+    int value = 0;
+
+    for (int i = 0; i < size; ++i) {
+        const ushort c = data[i].unicode();
+        if (c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0');
+            if (++groupLength > 3 || value > 255) {
+                return QValidator::Invalid;
+            }
+        } else if (c == '.') {
+            // the last tetrad can be empty, the other ones not
+            if (groupLength == 0 || ++groups > 4) {
+                return QValidator::Invalid;
+            }
+            groupLength = 0;
+            value = 0;
+        } else if (c == '/' && style == WithCidr && groups == 4 && groupLength > 0) {
+            return checkPrefix(address, i + 1, prefixLength);
+        } else {
             return QValidator::Invalid;
         }
+    }
 
-        // correct tetrad value: for example, 001 -> 1
-        temp.append(QString::number(tetrads[i]));
-
-        i++;
+    if (groups < 4 || groupLength == 0 || style == WithCidr) {
+        // not all tetrads are filled or the prefix is missing... continue
+        return QValidator::Intermediate;
     }
 
-    // replace input string with the corrected version
-    value = temp.join(QLatin1String("."));
+    return QValidator::Acceptable;
+}
+
+QValidator::State SimpleIpV4AddressValidator::checkPrefix(const QStringRef &address, int start, int *prefixLength)
+{
+    const QChar *data = address.unicode();
+    const int size = address.size();
 
-    if (i < 4) {
-        // not all tetrads are filled... continue
-        // qCDebug(PLASMA_NM) << "QValidator::Intermediate";
+    if (start == size) {
         return QValidator::Intermediate;
     }
-    else {
-        // qCDebug(PLASMA_NM) << "QValidator::Acceptable";
-        return QValidator::Acceptable;
+
+    int prefix = 0;
+    for (int i = start; i < size; ++i) {
+        const ushort c = data[i].unicode();
+        if (c < '0' || c > '9') {
+            return QValidator::Invalid;
+        }
+        prefix = prefix * 10 + (c - '0');
+        if (prefix > 32) {
+            return QValidator::Invalid;
+        }
+    }
+
+    if (prefixLength) {
+        *prefixLength = prefix;
     }
+    return QValidator::Acceptable;
+}
+
+bool SimpleIpV4AddressValidator::isValidList(const QString &list, AddressStyle style)
+{
+    const QChar *data = list.constData();
+    const int size = list.size();
+
+    int start = 0;
+    while (start <= size) {
+        int end = start;
+        while (end < size && data[end] != QLatin1Char(',')) {
+            ++end;
+        }
+
+        int first = start;
+        int last = end;
+        while (first < last && data[first].isSpace()) {
+            ++first;
+        }
+        while (last > first && data[last - 1].isSpace()) {
+            --last;
+        }
+
+        if (checkAddress(list.midRef(first, last - first), style) != QValidator::Acceptable) {
+            return false;
+        }
+
+        start = end + 1;
+    }
+
+    return true;
 }
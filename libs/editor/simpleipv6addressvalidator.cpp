@@ -19,11 +19,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "simpleipv6addressvalidator.h"
+#include "simpleipv4addressvalidator.h"
 
-#include <QStringList>
-
-SimpleIpV6AddressValidator::SimpleIpV6AddressValidator(QObject *parent)
+SimpleIpV6AddressValidator::SimpleIpV6AddressValidator(QObject *parent, AddressStyle style)
     : QValidator(parent)
+    , m_style(style)
 {
 }
 
@@ -33,53 +33,190 @@ SimpleIpV6AddressValidator::~SimpleIpV6AddressValidator()
 
 QValidator::State SimpleIpV6AddressValidator::validate(QString &address, int &pos) const
 {
-    if (QValidator::Invalid == checkWithInputMask(address, pos)) {
-        return QValidator::Invalid;
-    }
+    Q_UNUSED(pos)
 
-    return checkTetradsRanges(address);
+    return checkAddress(QStringRef(&address), m_style);
 }
 
 QValidator::State SimpleIpV6AddressValidator::checkWithInputMask(QString &value, int &pos) const
 {
-    QRegExpValidator v(QRegExp(QLatin1String("([0-9a-fA-F]{1,4}|:)+")), 0);
+    Q_UNUSED(pos)
+
+    int groupLength = 0;
+    Q_FOREACH (const QChar &c, value) {
+        if (c == QLatin1Char(':')) {
+            groupLength = 0;
+        } else if ((c >= QLatin1Char('0') && c <= QLatin1Char('9')) || (c >= QLatin1Char('a') && c <= QLatin1Char('f')) || (c >= QLatin1Char('A') && c <= QLatin1Char('F'))) {
+            if (++groupLength > 4) {
+                return QValidator::Invalid;
+            }
+        } else {
+            return QValidator::Invalid;
+        }
+    }
 
-    return v.validate(value, pos);
+    return value.isEmpty() ? QValidator::Intermediate : QValidator::Acceptable;
 }
 
 QValidator::State SimpleIpV6AddressValidator::checkTetradsRanges(QString &value) const
 {
-    const QStringList addrParts = value.split(QLatin1Char(':'));
-    int number = addrParts.size();
-    if (number > 8) {
-        return QValidator::Invalid;
-    }
+    return checkAddress(QStringRef(&value));
+}
 
-    // lets check address parts
-    bool emptypresent = false;
-    int i = 1;
-    Q_FOREACH (QString part, addrParts) { // krazy:exclude=Q_FOREACH 
-        if (part.isEmpty() && i < number) {
-            if (emptypresent) {
-                // qCDebug(PLASMA_NM) << "part.isEmpty()";
+QValidator::State SimpleIpV6AddressValidator::checkAddress(const QStringRef &address, AddressStyle style, int *prefixLength)
+{
+    const QChar *data = address.unicode();
+    const int size = address.size();
+
+    int groups = 0;
+    int groupLength = 0;
+    int groupStart = 0;
+    // number of colons right before the current position
+    int colons = 0;
+    bool compressed = false;
+
+    for (int i = 0; i < size; ++i) {
+        const ushort c = data[i].unicode();
+        if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')) {
+            // a single leading colon can only be followed by another one
+            if (i == 1 && colons == 1) {
                 return QValidator::Invalid;
             }
-            else if (!emptypresent)
-            {
-                part.setNum(0,16);
-                emptypresent = true;
+            if (groupLength == 0) {
+                groupStart = i;
             }
+            if (++groupLength > 4) {
+                return QValidator::Invalid;
+            }
+            colons = 0;
+        } else if (c == ':') {
+            if (groupLength > 0) {
+                // the eighth group has to be the last one
+                if (++groups == 8) {
+                    return QValidator::Invalid;
+                }
+                groupLength = 0;
+            }
+            if (++colons == 2) {
+                if (compressed) {
+                    return QValidator::Invalid;
+                }
+                compressed = true;
+            } else if (colons > 2) {
+                return QValidator::Invalid;
+            }
+        } else if (c == '.' && groupLength > 0) {
+            // an embedded IPv4 address (e.g. ::ffff:192.0.2.1) stands for the last two groups
+            groups += 2;
+            if (groups > 8 || (compressed && groups > 7)) {
+                return QValidator::Invalid;
+            }
+            int end = groupStart;
+            while (end < size && data[end] != QLatin1Char('/')) {
+                ++end;
+            }
+            if (end < size && style != WithCidr) {
+                return QValidator::Invalid;
+            }
+            const QValidator::State state = SimpleIpV4AddressValidator::checkAddress(QStringRef(address.string(), address.position() + groupStart, end - groupStart));
+            if (state != QValidator::Acceptable) {
+                return state;
+            }
+            if ((!compressed && groups < 8) || (style == WithCidr && end == size)) {
+                return QValidator::Intermediate;
+            }
+            return style == WithCidr ? checkPrefix(address, end + 1, prefixLength) : QValidator::Acceptable;
+        } else if (c == '/' && style == WithCidr && (groupLength > 0 || colons == 2)) {
+            if (groupLength > 0) {
+                ++groups;
+            }
+            if (groups > 8 || (compressed && groups > 7)) {
+                return QValidator::Invalid;
+            }
+            if (!compressed && groups < 8) {
+                return QValidator::Intermediate;
+            }
+            return checkPrefix(address, i + 1, prefixLength);
+        } else {
+            return QValidator::Invalid;
         }
-        i++;
 
-        bool ok;
-        if (part.toInt(&ok, 16) > 65535) {
+        // "::" stands for at least one group
+        if (groups > 8 || (compressed && groups > 7)) {
             return QValidator::Invalid;
         }
     }
 
-    if (number < 8 && !emptypresent)
+    if (groupLength > 0) {
+        ++groups;
+    }
+
+    if (groups > 8 || (compressed && groups > 7)) {
+        return QValidator::Invalid;
+    }
+
+    // trailing single colon, not enough groups or the prefix is missing
+    if (colons == 1 || (!compressed && groups < 8) || style == WithCidr) {
         return QValidator::Intermediate;
+    }
 
     return QValidator::Acceptable;
 }
+
+QValidator::State SimpleIpV6AddressValidator::checkPrefix(const QStringRef &address, int start, int *prefixLength)
+{
+    const QChar *data = address.unicode();
+    const int size = address.size();
+
+    if (start == size) {
+        return QValidator::Intermediate;
+    }
+
+    int prefix = 0;
+    for (int i = start; i < size; ++i) {
+        const ushort c = data[i].unicode();
+        if (c < '0' || c > '9') {
+            return QValidator::Invalid;
+        }
+        prefix = prefix * 10 + (c - '0');
+        if (prefix > 128) {
+            return QValidator::Invalid;
+        }
+    }
+
+    if (prefixLength) {
+        *prefixLength = prefix;
+    }
+    return QValidator::Acceptable;
+}
+
+bool SimpleIpV6AddressValidator::isValidList(const QString &list, AddressStyle style)
+{
+    const QChar *data = list.constData();
+    const int size = list.size();
+
+    int start = 0;
+    while (start <= size) {
+        int end = start;
+        while (end < size && data[end] != QLatin1Char(',')) {
+            ++end;
+        }
+
+        int first = start;
+        int last = end;
+        while (first < last && data[first].isSpace()) {
+            ++first;
+        }
+        while (last > first && data[last - 1].isSpace()) {
+            --last;
+        }
+
+        if (checkAddress(list.midRef(first, last - first), style) != QValidator::Acceptable) {
+            return false;
+        }
+
+        start = end + 1;
+    }
+
+    return true;
+}
@@ -26,18 +26,41 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 class Q_DECL_EXPORT SimpleIpV6AddressValidator : public QValidator
 {
 public:
-    explicit SimpleIpV6AddressValidator(QObject *parent);
+    enum AddressStyle {
+        Base,
+        WithCidr
+    };
+
+    explicit SimpleIpV6AddressValidator(QObject *parent, AddressStyle style = Base);
     virtual ~SimpleIpV6AddressValidator();
 
     virtual State validate(QString &, int &) const;
 
-    /** Check input value with a regular expression describing simple input mask.
+    /** Check input value against a simple input mask: groups of up to four
+     *  hexadecimal digits and colons.
      */
     QValidator::State checkWithInputMask(QString &, int &) const;
     /** Function split intput string into tetrads and check them for valid values.
      *  In the tetrads are placed into QList. Input string may be changed.
      */
     QValidator::State checkTetradsRanges(QString &) const;
+
+    /** Checks the address in a single pass without allocating memory.
+     *  At most one "::" is accepted, the last two groups can be written as an IPv4 address.
+     *  With the WithCidr style the address has to be followed by a network prefix
+     *  which is stored in prefixLength.
+     */
+    static QValidator::State checkAddress(const QStringRef &address, AddressStyle style = Base, int *prefixLength = nullptr);
+    /** Returns true when every item of the comma separated list is a complete address,
+     *  spaces around the items are ignored.
+     */
+    static bool isValidList(const QString &list, AddressStyle style = Base);
+
+private:
+    // Checks the network prefix following the slash at start - 1
+    static QValidator::State checkPrefix(const QStringRef &address, int start, int *prefixLength);
+
+    AddressStyle m_style;
 };
 
 #endif // SIMPLEIPV6ADDRESSVALIDATOR_H
@@ -0,0 +1,105 @@
+/*
+    Copyright 2026 agent <agent@local>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "slaveconnectionindex.h"
+
+#include <NetworkManagerQt/Settings>
+
+Q_GLOBAL_STATIC(SlaveConnectionIndex, s_slaveConnectionIndex)
+
+SlaveConnectionIndex *SlaveConnectionIndex::self()
+{
+    return s_slaveConnectionIndex;
+}
+
+SlaveConnectionIndex::SlaveConnectionIndex(QObject *parent)
+    : QObject(parent)
+{
+    Q_FOREACH (const NetworkManager::Connection::Ptr &connection, NetworkManager::listConnections()) {
+        addConnection(connection);
+    }
+
+    connect(NetworkManager::settingsNotifier(), &NetworkManager::SettingsNotifier::connectionAdded, this, &SlaveConnectionIndex::connectionAdded);
+    connect(NetworkManager::settingsNotifier(), &NetworkManager::SettingsNotifier::connectionRemoved, this, &SlaveConnectionIndex::connectionRemoved);
+}
+
+SlaveConnectionIndex::~SlaveConnectionIndex()
+{
+}
+
+NetworkManager::Connection::List SlaveConnectionIndex::slaves(const QString &master, const QString &slaveType) const
+{
+    NetworkManager::Connection::List result;
+
+    if (master.isEmpty()) {
+        return result;
+    }
+
+    QMultiHash<QString, QString>::const_iterator it = m_slaves.constFind(master);
+    for (; it != m_slaves.constEnd() && it.key() == master; ++it) {
+        NetworkManager::Connection::Ptr connection = NetworkManager::findConnection(it.value());
+        if (connection && (slaveType.isEmpty() || connection->settings()->slaveType() == slaveType)) {
+            result << connection;
+        }
+    }
+
+    return result;
+}
+
+void SlaveConnectionIndex::connectionAdded(const QString &path)
+{
+    NetworkManager::Connection::Ptr connection = NetworkManager::findConnection(path);
+    if (connection) {
+        addConnection(connection);
+    }
+}
+
+void SlaveConnectionIndex::connectionRemoved(const QString &path)
+{
+    if (m_masters.contains(path)) {
+        const QString master = m_masters.take(path);
+        m_slaves.remove(master, path);
+        Q_EMIT slavesChanged(master);
+    }
+}
+
+void SlaveConnectionIndex::connectionUpdated()
+{
+    NetworkManager::Connection *connection = qobject_cast<NetworkManager::Connection*>(sender());
+    if (connection) {
+        // Master might have changed
+        connectionRemoved(connection->path());
+        connectionAdded(connection->path());
+    }
+}
+
+void SlaveConnectionIndex::addConnection(const NetworkManager::Connection::Ptr &connection)
+{
+    connect(connection.data(), &NetworkManager::Connection::updated, this, &SlaveConnectionIndex::connectionUpdated, Qt::UniqueConnection);
+
+    NetworkManager::ConnectionSettings::Ptr settings = connection->settings();
+    if (!settings || settings->master().isEmpty()) {
+        return;
+    }
+
+    m_slaves.insert(settings->master(), connection->path());
+    m_masters.insert(connection->path(), settings->master());
+    Q_EMIT slavesChanged(settings->master());
+}
@@ -0,0 +1,67 @@
+/*
+    Copyright 2026 agent <agent@local>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLASMA_NM_SLAVE_CONNECTION_INDEX_H
+#define PLASMA_NM_SLAVE_CONNECTION_INDEX_H
+
+#include <QObject>
+#include <QMultiHash>
+
+#include <NetworkManagerQt/Connection>
+
+/**
+ * Process wide index of saved slave connections by their master,
+ * kept up to date from the settings notifications
+ */
+class Q_DECL_EXPORT SlaveConnectionIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static SlaveConnectionIndex *self();
+
+    explicit SlaveConnectionIndex(QObject *parent = nullptr);
+    virtual ~SlaveConnectionIndex();
+
+    /**
+     * @brief slaves returns saved connections enslaved to given master
+     * @param master UUID or interface name of the master connection
+     * @param slaveType for example "bond", empty for all types
+     */
+    NetworkManager::Connection::List slaves(const QString &master, const QString &slaveType = QString()) const;
+
+Q_SIGNALS:
+    // Emitted when a slave of the master was added, removed or modified
+    void slavesChanged(const QString &master);
+
+private Q_SLOTS:
+    void connectionAdded(const QString &path);
+    void connectionRemoved(const QString &path);
+    void connectionUpdated();
+
+private:
+    void addConnection(const NetworkManager::Connection::Ptr &connection);
+
+    // Master -> slave connection paths
+    QMultiHash<QString, QString> m_slaves;
+    // Slave connection path -> master
+    QHash<QString, QString> m_masters;
+};
+
+#endif // PLASMA_NM_SLAVE_CONNECTION_INDEX_H
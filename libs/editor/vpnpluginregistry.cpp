@@ -0,0 +1,149 @@
+/*
+    Copyright 2026 agent <agent@local>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "vpnpluginregistry.h"
+
+#include "debug.h"
+#include "vpnuiplugin.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
+
+#include <KServiceTypeTrader>
+
+class VpnPluginRegistrySingleton
+{
+public:
+    VpnPluginRegistry self;
+};
+
+Q_GLOBAL_STATIC(VpnPluginRegistrySingleton, s_vpnPluginRegistry)
+
+VpnPluginRegistry *VpnPluginRegistry::self()
+{
+    return &s_vpnPluginRegistry->self;
+}
+
+VpnPluginRegistry::VpnPluginRegistry()
+    : m_extensionsLoaded(false)
+{
+    KService::List services = KServiceTypeTrader::self()->query(QStringLiteral("PlasmaNetworkManagement/VpnUiPlugin"));
+
+    std::sort(services.begin(), services.end(), [] (const KService::Ptr &left, const KService::Ptr &right)
+    {
+        return QString::localeAwareCompare(left->name(), right->name()) <= 0;
+    });
+
+    Q_FOREACH (const KService::Ptr &service, services) {
+        PluginInfo info;
+        info.name = service->name();
+        info.comment = service->property(QStringLiteral("Comment"), QVariant::String).toString();
+        info.serviceType = service->property(QStringLiteral("X-NetworkManager-Services"), QVariant::String).toString();
+        info.subType = service->property(QStringLiteral("X-NetworkManager-Services-Subtype"), QVariant::String).toString();
+        m_plugins << info;
+
+        // Several entries might share the service type, the first one wins like with the trader queries
+        if (!m_services.contains(info.serviceType)) {
+            m_services.insert(info.serviceType, service);
+        }
+    }
+}
+
+QList<VpnPluginRegistry::PluginInfo> VpnPluginRegistry::plugins() const
+{
+    return m_plugins;
+}
+
+bool VpnPluginRegistry::hasPlugin(const QString &serviceType) const
+{
+    return m_services.contains(serviceType);
+}
+
+VpnUiPlugin *VpnPluginRegistry::plugin(const QString &serviceType, QString *error)
+{
+    VpnUiPlugin *vpnPlugin = m_instances.value(serviceType);
+    if (vpnPlugin) {
+        return vpnPlugin;
+    }
+
+    KService::Ptr service = m_services.value(serviceType);
+    if (!service) {
+        if (error) {
+            *error = QStringLiteral("No VPN plugin for %1").arg(serviceType);
+        }
+        return nullptr;
+    }
+
+    // Plugins live as long as the application, widgets they create get their own parents
+    QString loadError;
+    vpnPlugin = service->createInstance<VpnUiPlugin>(QCoreApplication::instance(), QVariantList(), &loadError);
+    if (!vpnPlugin) {
+        qCWarning(PLASMA_NM) << "Failed to load VPN plugin" << serviceType << loadError;
+        if (error) {
+            *error = loadError;
+        }
+        return nullptr;
+    }
+
+    m_instances.insert(serviceType, vpnPlugin);
+    return vpnPlugin;
+}
+
+QString VpnPluginRegistry::fileExtensions()
+{
+    loadExtensions();
+
+    QStringList extensions = m_extensions.uniqueKeys();
+    extensions.sort();
+    return extensions.join(QLatin1Char(' '));
+}
+
+QStringList VpnPluginRegistry::serviceTypesForExtension(const QString &extension)
+{
+    loadExtensions();
+
+    QStringList serviceTypes = m_extensions.values(extension.toLower());
+    // QMultiHash returns the most recently inserted first
+    std::reverse(serviceTypes.begin(), serviceTypes.end());
+    return serviceTypes;
+}
+
+void VpnPluginRegistry::loadExtensions()
+{
+    if (m_extensionsLoaded) {
+        return;
+    }
+    m_extensionsLoaded = true;
+
+    Q_FOREACH (const PluginInfo &info, m_plugins) {
+        VpnUiPlugin *vpnPlugin = plugin(info.serviceType);
+        if (!vpnPlugin) {
+            continue;
+        }
+
+        // The format is: *.<extension> [*.<extension> ...]
+        Q_FOREACH (const QString &extension, vpnPlugin->supportedFileExtensions().split(QLatin1Char(' '), QString::SkipEmptyParts)) {
+            if (!m_extensions.contains(extension.toLower(), info.serviceType)) {
+                m_extensions.insert(extension.toLower(), info.serviceType);
+            }
+        }
+    }
+}
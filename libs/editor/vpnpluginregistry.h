@@ -0,0 +1,86 @@
+/*
+    Copyright 2026 agent <agent@local>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLASMA_NM_VPN_PLUGIN_REGISTRY_H
+#define PLASMA_NM_VPN_PLUGIN_REGISTRY_H
+
+#include <QHash>
+#include <QPointer>
+#include <QStringList>
+
+#include <KService>
+
+class VpnUiPlugin;
+
+/**
+ * Process wide cache of installed VPN UI plugins, the metadata is queried once
+ * and loaded plugins are kept until the application quits
+ */
+class Q_DECL_EXPORT VpnPluginRegistry
+{
+public:
+    struct PluginInfo {
+        QString name;
+        QString comment;
+        QString serviceType;
+        QString subType;
+    };
+
+    static VpnPluginRegistry *self();
+
+    /**
+     * @return all installed plugins sorted by their name
+     */
+    QList<PluginInfo> plugins() const;
+    bool hasPlugin(const QString &serviceType) const;
+
+    /**
+     * @brief plugin returns the plugin for given VPN service type
+     * @param serviceType for example org.freedesktop.NetworkManager.openvpn
+     * @param error set to the error message if the plugin couldn't be loaded
+     * @return the plugin, owned by the registry, or nullptr
+     */
+    VpnUiPlugin *plugin(const QString &serviceType, QString *error = nullptr);
+
+    /**
+     * @return file name filter with extensions of all plugins which can import files
+     */
+    QString fileExtensions();
+    /**
+     * @brief serviceTypesForExtension returns plugins which can import files with the extension
+     * @param extension extension in the form *.ovpn
+     */
+    QStringList serviceTypesForExtension(const QString &extension);
+
+private:
+    VpnPluginRegistry();
+    void loadExtensions();
+
+    QList<PluginInfo> m_plugins;
+    QHash<QString, KService::Ptr> m_services;
+    QHash<QString, QPointer<VpnUiPlugin> > m_instances;
+    // Filled the first time file extensions are needed, all plugins have to be loaded for that
+    bool m_extensionsLoaded;
+    QMultiHash<QString, QString> m_extensions;
+
+    friend class VpnPluginRegistrySingleton;
+};
+
+#endif // PLASMA_NM_VPN_PLUGIN_REGISTRY_H
@@ -21,22 +21,34 @@
 
 #include "bssidcombobox.h"
 
+#include <QAbstractItemView>
+#include <QSignalBlocker>
+#include <QTimer>
+
 #include <NetworkManagerQt/Manager>
 #include <NetworkManagerQt/Utils>
 #include <NetworkManagerQt/WirelessDevice>
 
 #include <KLocalizedString>
 
+#include <algorithm>
+
+#define BSSID_REFRESH_INTERVAL 1000
+
 bool signalCompare(const NetworkManager::AccessPoint::Ptr & one, const NetworkManager::AccessPoint::Ptr & two) {
     return one->signalStrength() > two->signalStrength();
 }
 
 BssidComboBox::BssidComboBox(QWidget *parent) :
-    QComboBox(parent), m_dirty(false)
+    QComboBox(parent), m_dirty(false), m_refreshTimer(new QTimer(this))
 {
     setEditable(true);
     setInsertPolicy(QComboBox::NoInsert);
 
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(BSSID_REFRESH_INTERVAL);
+    connect(m_refreshTimer, &QTimer::timeout, this, &BssidComboBox::refresh);
+
     connect(this, &BssidComboBox::editTextChanged, this, &BssidComboBox::slotEditTextChanged);
     connect(this, static_cast<void (BssidComboBox::*)(int)>(&BssidComboBox::activated), this, &BssidComboBox::slotCurrentIndexChanged);
 }
@@ -79,43 +91,27 @@ void BssidComboBox::slotCurrentIndexChanged(int)
 void BssidComboBox::init(const QString & bssid, const QString &ssid)
 {
     m_initialBssid = bssid;
+    m_ssid = ssid;
 
     // qCDebug(PLASMA_NM) << "Initial ssid:" << m_initialBssid;
 
-    QList<NetworkManager::AccessPoint::Ptr> aps;
+    m_accessPoints.clear();
+    m_bssids.clear();
+    m_refreshTimer->stop();
 
     Q_FOREACH (const NetworkManager::Device::Ptr & device, NetworkManager::networkInterfaces()) {
         if (device->type() == NetworkManager::Device::Wifi) {
             NetworkManager::WirelessDevice::Ptr wifiDevice = device.objectCast<NetworkManager::WirelessDevice>();
-            NetworkManager::WirelessNetwork::Ptr wifiNetwork = wifiDevice->findNetwork(ssid);
-
-            if (!wifiNetwork) {
-                continue;
-            }
+            connect(wifiDevice.data(), &NetworkManager::WirelessDevice::networkAppeared, this, &BssidComboBox::slotNetworkAppeared, Qt::UniqueConnection);
 
-            Q_FOREACH (const NetworkManager::AccessPoint::Ptr & newAp, wifiNetwork->accessPoints()) {
-                bool found = false;;
-                Q_FOREACH (const NetworkManager::AccessPoint::Ptr & existingAp, aps) {
-                    if (newAp->hardwareAddress() == existingAp->hardwareAddress()) {
-                        if (newAp->signalStrength() > existingAp->signalStrength()) {
-                            aps.removeOne(existingAp);
-                            break;
-                        } else {
-                            found = true;
-                            break;
-                        }
-                    }
-                }
-
-                if (!found) {
-                    aps << newAp;
-                }
+            NetworkManager::WirelessNetwork::Ptr wifiNetwork = wifiDevice->findNetwork(ssid);
+            if (wifiNetwork) {
+                addNetwork(wifiNetwork);
             }
         }
     }
 
-    qSort(aps.begin(), aps.end(), signalCompare);
-    addBssidsToCombo(aps);
+    addBssidsToCombo(accessPoints());
 
     const int index = findData(m_initialBssid);
     if (index == -1) {
@@ -127,6 +123,143 @@ void BssidComboBox::init(const QString & bssid, const QString &ssid)
     setEditText(m_initialBssid);
 }
 
+void BssidComboBox::slotNetworkAppeared(const QString &ssid)
+{
+    NetworkManager::WirelessDevice *wifiDevice = qobject_cast<NetworkManager::WirelessDevice *>(sender());
+    if (!wifiDevice || ssid != m_ssid) {
+        return;
+    }
+
+    NetworkManager::WirelessNetwork::Ptr wifiNetwork = wifiDevice->findNetwork(ssid);
+    if (wifiNetwork) {
+        addNetwork(wifiNetwork);
+        scheduleRefresh();
+    }
+}
+
+void BssidComboBox::slotAccessPointAppeared(const QString &uni)
+{
+    NetworkManager::WirelessNetwork *wifiNetwork = qobject_cast<NetworkManager::WirelessNetwork *>(sender());
+    // Networks of previously selected SSIDs stay connected
+    if (!wifiNetwork || wifiNetwork->ssid() != m_ssid) {
+        return;
+    }
+
+    NetworkManager::WirelessDevice::Ptr wifiDevice = NetworkManager::findNetworkInterface(wifiNetwork->device()).objectCast<NetworkManager::WirelessDevice>();
+    NetworkManager::AccessPoint::Ptr ap = wifiDevice ? wifiDevice->findAccessPoint(uni) : NetworkManager::AccessPoint::Ptr();
+    if (ap) {
+        addAccessPoint(ap);
+        scheduleRefresh();
+    }
+}
+
+void BssidComboBox::slotAccessPointDisappeared(const QString &uni)
+{
+    const QString bssid = m_bssids.take(uni);
+    if (bssid.isEmpty()) {
+        return;
+    }
+
+    QMultiHash<QString, NetworkManager::AccessPoint::Ptr>::iterator it = m_accessPoints.find(bssid);
+    while (it != m_accessPoints.end() && it.key() == bssid) {
+        if (it.value()->uni() == uni) {
+            it = m_accessPoints.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    scheduleRefresh();
+}
+
+void BssidComboBox::slotSignalStrengthChanged()
+{
+    NetworkManager::AccessPoint *ap = qobject_cast<NetworkManager::AccessPoint *>(sender());
+    if (ap && m_bssids.contains(ap->uni())) {
+        scheduleRefresh();
+    }
+}
+
+void BssidComboBox::addNetwork(const NetworkManager::WirelessNetwork::Ptr &network)
+{
+    connect(network.data(), &NetworkManager::WirelessNetwork::accessPointAppeared, this, &BssidComboBox::slotAccessPointAppeared, Qt::UniqueConnection);
+    connect(network.data(), &NetworkManager::WirelessNetwork::accessPointDisappeared, this, &BssidComboBox::slotAccessPointDisappeared, Qt::UniqueConnection);
+
+    Q_FOREACH (const NetworkManager::AccessPoint::Ptr & ap, network->accessPoints()) {
+        addAccessPoint(ap);
+    }
+}
+
+void BssidComboBox::addAccessPoint(const NetworkManager::AccessPoint::Ptr &ap)
+{
+    if (!ap || m_bssids.contains(ap->uni())) {
+        return;
+    }
+
+    m_bssids.insert(ap->uni(), ap->hardwareAddress());
+    m_accessPoints.insert(ap->hardwareAddress(), ap);
+    connect(ap.data(), &NetworkManager::AccessPoint::signalStrengthChanged, this, &BssidComboBox::slotSignalStrengthChanged, Qt::UniqueConnection);
+}
+
+QList<NetworkManager::AccessPoint::Ptr> BssidComboBox::accessPoints() const
+{
+    QList<NetworkManager::AccessPoint::Ptr> aps;
+
+    // Values with the same key are adjacent, keep the strongest of them
+    QMultiHash<QString, NetworkManager::AccessPoint::Ptr>::const_iterator it = m_accessPoints.constBegin();
+    while (it != m_accessPoints.constEnd()) {
+        const QString bssid = it.key();
+        NetworkManager::AccessPoint::Ptr bestAp = it.value();
+        for (++it; it != m_accessPoints.constEnd() && it.key() == bssid; ++it) {
+            if (it.value()->signalStrength() > bestAp->signalStrength()) {
+                bestAp = it.value();
+            }
+        }
+        aps << bestAp;
+    }
+
+    std::sort(aps.begin(), aps.end(), signalCompare);
+    return aps;
+}
+
+void BssidComboBox::scheduleRefresh()
+{
+    if (!m_refreshTimer->isActive()) {
+        m_refreshTimer->start();
+    }
+}
+
+void BssidComboBox::refresh()
+{
+    // Don't move items under the mouse cursor
+    if (view()->isVisible()) {
+        m_refreshTimer->start();
+        return;
+    }
+
+    const bool dirty = m_dirty;
+    const QString text = currentText();
+    const QString currentBssid = itemData(currentIndex()).toString();
+
+    QSignalBlocker blocker(this);
+
+    addBssidsToCombo(accessPoints());
+
+    if (findData(m_initialBssid) == -1) {
+        insertItem(0, m_initialBssid, m_initialBssid);
+    }
+
+    // Keep the selected access point even when it went out of range
+    int index = findData(currentBssid);
+    if (index == -1) {
+        insertItem(0, currentBssid, currentBssid);
+        index = 0;
+    }
+    setCurrentIndex(index);
+    setEditText(text);
+    m_dirty = dirty;
+}
+
 void BssidComboBox::addBssidsToCombo(const QList<NetworkManager::AccessPoint::Ptr> & aps)
 {
     clear();
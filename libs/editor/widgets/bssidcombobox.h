@@ -23,9 +23,13 @@
 #define PLASMA_NM_BSSIDCOMBOBOX_H
 
 #include <QComboBox>
+#include <QMultiHash>
 
 #include <NetworkManagerQt/Device>
 #include <NetworkManagerQt/AccessPoint>
+#include <NetworkManagerQt/WirelessNetwork>
+
+class QTimer;
 
 class Q_DECL_EXPORT BssidComboBox : public QComboBox
 {
@@ -45,12 +49,31 @@ public Q_SLOTS:
 private Q_SLOTS:
     void slotEditTextChanged(const QString &);
     void slotCurrentIndexChanged(int);
+    void slotNetworkAppeared(const QString &ssid);
+    void slotAccessPointAppeared(const QString &uni);
+    void slotAccessPointDisappeared(const QString &uni);
+    void slotSignalStrengthChanged();
+    void refresh();
 
 private:
     void addBssidsToCombo(const QList<NetworkManager::AccessPoint::Ptr> & aps);
+    void addNetwork(const NetworkManager::WirelessNetwork::Ptr &network);
+    void addAccessPoint(const NetworkManager::AccessPoint::Ptr &ap);
+    /**
+     * @return the strongest access point for every BSSID sorted by signal strength
+     */
+    QList<NetworkManager::AccessPoint::Ptr> accessPoints() const;
+    void scheduleRefresh();
 
     QString m_initialBssid;
+    QString m_ssid;
     bool m_dirty;
+    // Access points of the SSID on all wireless devices by BSSID
+    QMultiHash<QString, NetworkManager::AccessPoint::Ptr> m_accessPoints;
+    // Access point path -> BSSID
+    QHash<QString, QString> m_bssids;
+    // Coalesces list updates caused by scan results
+    QTimer *m_refreshTimer;
 };
 
 #endif // PLASMA_NM_BSSIDCOMBOBOX_H
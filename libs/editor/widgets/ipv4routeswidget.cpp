@@ -18,34 +18,32 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <QStandardItem>
-#include <QStandardItemModel>
+#include <QAction>
+#include <QApplication>
+#include <QClipboard>
 #include <QNetworkAddressEntry>
 
 #include <KAcceleratorManager>
 #include <KLocalizedString>
+#include <KMessageBox>
+
+#include <algorithm>
+#include <functional>
 
 #include "ui_ipv4routes.h"
 #include "ipv4routeswidget.h"
 #include "ipv4delegate.h"
 #include "intdelegate.h"
+#include "routetablemodel.h"
 
 class IpV4RoutesWidget::Private
 {
 public:
-    Private() : model(0,4)
+    Private() : model(QAbstractSocket::IPv4Protocol)
     {
-        QStandardItem * headerItem = new QStandardItem(i18nc("Header text for IPv4 address", "Address"));
-        model.setHorizontalHeaderItem(0, headerItem);
-        headerItem = new QStandardItem(i18nc("Header text for IPv4 netmask", "Netmask"));
-        model.setHorizontalHeaderItem(1, headerItem);
-        headerItem = new QStandardItem(i18nc("Header text for IPv4 gateway", "Gateway"));
-        model.setHorizontalHeaderItem(2, headerItem);
-        headerItem = new QStandardItem(i18nc("Header text for IPv4 route metric", "Metric"));
-        model.setHorizontalHeaderItem(3, headerItem);
     }
     Ui_RoutesIp4Config ui;
-    QStandardItemModel model;
+    RouteTableModel model;
 };
 
 IpV4RoutesWidget::IpV4RoutesWidget(QWidget * parent)
@@ -67,7 +65,18 @@ IpV4RoutesWidget::IpV4RoutesWidget(QWidget * parent)
 
     connect(d->ui.tableViewAddresses->selectionModel(), &QItemSelectionModel::selectionChanged, this, &IpV4RoutesWidget::selectionChanged);
 
-    connect(&d->model, &QStandardItemModel::itemChanged, this, &IpV4RoutesWidget::tableViewItemChanged);
+    connect(&d->model, &RouteTableModel::dataChanged, this, &IpV4RoutesWidget::routeChanged);
+    // Routes can't be accepted while some cell shows text which couldn't be parsed
+    connect(&d->model, &RouteTableModel::dataChanged, this, &IpV4RoutesWidget::updateOkButton);
+    connect(&d->model, &RouteTableModel::rowsRemoved, this, &IpV4RoutesWidget::updateOkButton);
+    connect(&d->model, &RouteTableModel::modelReset, this, &IpV4RoutesWidget::updateOkButton);
+
+    QAction *pasteAction = new QAction(QIcon::fromTheme(QStringLiteral("edit-paste")), i18n("Paste Routes"), this);
+    pasteAction->setShortcut(QKeySequence::Paste);
+    pasteAction->setShortcutContext(Qt::WidgetShortcut);
+    connect(pasteAction, &QAction::triggered, this, &IpV4RoutesWidget::pasteRoutes);
+    d->ui.tableViewAddresses->addAction(pasteAction);
+    d->ui.tableViewAddresses->setContextMenuPolicy(Qt::ActionsContextMenu);
 
     connect(d->ui.buttonBox, &QDialogButtonBox::accepted, this, &IpV4RoutesWidget::accept);
     connect(d->ui.buttonBox, &QDialogButtonBox::rejected, this, &IpV4RoutesWidget::reject);
@@ -107,74 +116,42 @@ bool IpV4RoutesWidget::ignoreautoroutes() const
 
 void IpV4RoutesWidget::setRoutes(const QList<NetworkManager::IpRoute> &list)
 {
-    d->model.removeRows(0, d->model.rowCount());
-    Q_FOREACH (const NetworkManager::IpRoute &route, list) {
-        QList<QStandardItem *> item;
-
-        // qCDebug(PLASMA_NM) << route.ip();
-        item << new QStandardItem(route.ip().toString())
-             << new QStandardItem(route.netmask().toString())
-             << new QStandardItem(route.nextHop().toString())
-             << new QStandardItem(QString::number(route.metric(), 10));
-
-        d->model.appendRow(item);
-    }
+    d->model.setRoutes(list);
 }
 
 QList<NetworkManager::IpRoute> IpV4RoutesWidget::routes()
 {
-    QList<NetworkManager::IpRoute> list;
-
-    for (int i = 0, rowCount = d->model.rowCount(); i < rowCount; i++) {
-        NetworkManager::IpRoute route;
-        QStandardItem *item = d->model.item(i,0);
-        if (item) {
-            route.setIp(QHostAddress(item->text()));
-        }
-        item = d->model.item(i, 1);
-        if (item) {
-            route.setNetmask(QHostAddress(item->text()));
-        }
-        item = d->model.item(i, 2);
-        if (item) {
-            route.setNextHop(QHostAddress(item->text()));
-        }
-        item = d->model.item(i, 3);
-        if (item) {
-            route.setMetric(item->text().toUInt());
-        }
-
-        list << route;
-    }
-    return list;
+    return d->model.routes();
 }
 
 void IpV4RoutesWidget::addRoute()
 {
-    QList<QStandardItem *> item;
-    item << new QStandardItem << new QStandardItem << new QStandardItem;
-    d->model.appendRow(item);
-
-    const int rowCount = d->model.rowCount();
-    if (rowCount > 0) {
-        d->ui.tableViewAddresses->selectRow(rowCount - 1);
-
-        QItemSelectionModel * selectionModel = d->ui.tableViewAddresses->selectionModel();
-        QModelIndexList list = selectionModel->selectedIndexes();
-        if (list.size()) {
-            // QTableView is configured to select only rows.
-            // So, list[0] - IP address.
-            d->ui.tableViewAddresses->edit(list[0]);
-        }
-    }
+    const int row = d->model.appendRoute();
+    d->ui.tableViewAddresses->selectRow(row);
+    d->ui.tableViewAddresses->edit(d->model.index(row, RouteTableModel::AddressColumn));
 }
 
 void IpV4RoutesWidget::removeRoute()
 {
     QItemSelectionModel * selectionModel = d->ui.tableViewAddresses->selectionModel();
     if (selectionModel->hasSelection()) {
-        QModelIndexList indexes = selectionModel->selectedIndexes();
-        d->model.takeRow(indexes[0].row());
+        // Remove selected rows from the bottom so that the row numbers stay valid,
+        // adjacent rows are removed at once
+        QList<int> rows;
+        Q_FOREACH (const QModelIndex &index, selectionModel->selectedRows()) {
+            rows << index.row();
+        }
+        std::sort(rows.begin(), rows.end(), std::greater<int>());
+
+        int i = 0;
+        while (i < rows.count()) {
+            int count = 1;
+            while (i + count < rows.count() && rows.at(i + count) == rows.at(i) - count) {
+                ++count;
+            }
+            d->model.removeRows(rows.at(i) - count + 1, count);
+            i += count;
+        }
     }
     d->ui.pushButtonRemove->setEnabled(d->ui.tableViewAddresses->selectionModel()->hasSelection());
 }
@@ -187,24 +164,45 @@ void IpV4RoutesWidget::selectionChanged(const QItemSelection & selected)
 
 extern quint32 suggestNetmask(quint32 ip);
 
-void IpV4RoutesWidget::tableViewItemChanged(QStandardItem *item)
+void IpV4RoutesWidget::routeChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
 {
-    if (item->text().isEmpty()) {
+    if (topLeft != bottomRight || topLeft.column() != RouteTableModel::AddressColumn) {
         return;
     }
 
-    const int column = item->column();
-    if (column == 0) { // ip
-        int row = item->row();
-
-        QStandardItem *netmaskItem = d->model.item(row, column + 1); // netmask
-        if (netmaskItem && netmaskItem->text().isEmpty()) {
-            QHostAddress addr(item->text());
-            quint32 netmask = suggestNetmask(addr.toIPv4Address());
-            if (netmask) {
-                QHostAddress v(netmask);
-                netmaskItem->setText(v.toString());
-            }
+    const QString address = topLeft.data().toString();
+    if (address.isEmpty() || d->model.hasInvalidValues(topLeft)) {
+        return;
+    }
+
+    const QModelIndex netmaskIndex = topLeft.sibling(topLeft.row(), RouteTableModel::NetmaskColumn);
+    if (netmaskIndex.data().toString().isEmpty()) {
+        QHostAddress addr(address);
+        quint32 netmask = suggestNetmask(addr.toIPv4Address());
+        if (netmask) {
+            QHostAddress v(netmask);
+            d->model.setData(netmaskIndex, v.toString());
+        }
+    }
+}
+
+void IpV4RoutesWidget::updateOkButton()
+{
+    d->ui.buttonBox->button(QDialogButtonBox::Ok)->setEnabled(!d->model.hasInvalidValues());
+}
+
+void IpV4RoutesWidget::pasteRoutes()
+{
+    QList<int> invalidLines;
+    d->model.importRoutes(QApplication::clipboard()->text(), &invalidLines);
+
+    if (!invalidLines.isEmpty()) {
+        QStringList lines;
+        Q_FOREACH (int line, invalidLines.mid(0, 10)) {
+            lines << QString::number(line);
         }
+        KMessageBox::sorry(this, i18np("Line %2 could not be imported as a route.",
+                                       "%1 lines could not be imported as routes, for example: %2",
+                                       invalidLines.count(), lines.join(QStringLiteral(", "))));
     }
 }
@@ -18,35 +18,33 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <QStandardItem>
-#include <QStandardItemModel>
+#include <QAction>
+#include <QApplication>
+#include <QClipboard>
 #include <QNetworkAddressEntry>
 
 #include <KAcceleratorManager>
 #include <KLocalizedString>
+#include <KMessageBox>
+
+#include <algorithm>
+#include <functional>
 
 #include "ui_ipv6routes.h"
 
 #include "ipv6delegate.h"
 #include "intdelegate.h"
+#include "routetablemodel.h"
 #include "ipv6routeswidget.h"
 
 class IpV6RoutesWidget::Private
 {
 public:
-    Private() : model(0,4)
+    Private() : model(QAbstractSocket::IPv6Protocol)
     {
-        QStandardItem * headerItem = new QStandardItem(i18nc("Header text for IPv6 address", "Address"));
-        model.setHorizontalHeaderItem(0, headerItem);
-        headerItem = new QStandardItem(i18nc("Header text for IPv6 netmask", "Netmask"));
-        model.setHorizontalHeaderItem(1, headerItem);
-        headerItem = new QStandardItem(i18nc("Header text for IPv6 gateway", "Gateway"));
-        model.setHorizontalHeaderItem(2, headerItem);
-        headerItem = new QStandardItem(i18nc("Header text for IPv6 route metric", "Metric"));
-        model.setHorizontalHeaderItem(3, headerItem);
     }
     Ui_RoutesIp6Config ui;
-    QStandardItemModel model;
+    RouteTableModel model;
 };
 
 IpV6RoutesWidget::IpV6RoutesWidget(QWidget * parent)
@@ -69,8 +67,18 @@ IpV6RoutesWidget::IpV6RoutesWidget(QWidget * parent)
 
     connect(d->ui.tableViewAddresses->selectionModel(), &QItemSelectionModel::selectionChanged, this, &IpV6RoutesWidget::selectionChanged);
 
+    connect(&d->model, &RouteTableModel::dataChanged, this, &IpV6RoutesWidget::routeChanged);
+    // Routes can't be accepted while some cell shows text which couldn't be parsed
+    connect(&d->model, &RouteTableModel::dataChanged, this, &IpV6RoutesWidget::updateOkButton);
+    connect(&d->model, &RouteTableModel::rowsRemoved, this, &IpV6RoutesWidget::updateOkButton);
+    connect(&d->model, &RouteTableModel::modelReset, this, &IpV6RoutesWidget::updateOkButton);
 
-    connect(&d->model, &QStandardItemModel::itemChanged, this, &IpV6RoutesWidget::tableViewItemChanged);
+    QAction *pasteAction = new QAction(QIcon::fromTheme(QStringLiteral("edit-paste")), i18n("Paste Routes"), this);
+    pasteAction->setShortcut(QKeySequence::Paste);
+    pasteAction->setShortcutContext(Qt::WidgetShortcut);
+    connect(pasteAction, &QAction::triggered, this, &IpV6RoutesWidget::pasteRoutes);
+    d->ui.tableViewAddresses->addAction(pasteAction);
+    d->ui.tableViewAddresses->setContextMenuPolicy(Qt::ActionsContextMenu);
 
     connect(d->ui.buttonBox, &QDialogButtonBox::accepted, this, &IpV6RoutesWidget::accept);
     connect(d->ui.buttonBox, &QDialogButtonBox::rejected, this, &IpV6RoutesWidget::reject);
@@ -110,75 +118,44 @@ bool IpV6RoutesWidget::ignoreautoroutes() const
 
 void IpV6RoutesWidget::setRoutes(const QList<NetworkManager::IpRoute> &list)
 {
-    d->model.removeRows(0, d->model.rowCount());
-    Q_FOREACH (const NetworkManager::IpRoute &route, list) {
-        QList<QStandardItem *> item;
-        // qCDebug(PLASMA_NM) << route.ip();
-        item << new QStandardItem(route.ip().toString())
-             << new QStandardItem(QString::number(route.prefixLength(), 10))
-             << new QStandardItem(route.nextHop().toString())
-             << new QStandardItem(QString::number(route.metric(), 10));
-
-        d->model.appendRow(item);
-    }
+    d->model.setRoutes(list);
 }
 
 QList<NetworkManager::IpRoute> IpV6RoutesWidget::routes()
 {
-    QList<NetworkManager::IpRoute> list;
-
-    for (int i = 0, rowCount = d->model.rowCount(); i < rowCount; i++) {
-        NetworkManager::IpRoute route;
-        QStandardItem *item = d->model.item(i,0);
-        if (item) {
-            route.setIp(QHostAddress(item->text()));
-        }
-        item = d->model.item(i, 2);
-        if (item) {
-            route.setNextHop(QHostAddress(item->text()));
-        }
-        item = d->model.item(i, 1);
-        if (item) {
-            route.setPrefixLength(item->text().toInt());
-        }
-        item = d->model.item(i, 3);
-        if (item) {
-            route.setMetric(item->text().toUInt());
-        }
-
-        list << route;
-    }
-    return list;
+    return d->model.routes();
 }
 
 void IpV6RoutesWidget::addRoute()
 {
-    QList<QStandardItem *> item;
-    item << new QStandardItem << new QStandardItem << new QStandardItem;
-    d->model.appendRow(item);
-
-    const int rowCount = d->model.rowCount();
-    if (rowCount > 0) {
-        d->ui.tableViewAddresses->selectRow(rowCount - 1);
-
-        QItemSelectionModel * selectionModel = d->ui.tableViewAddresses->selectionModel();
-        QModelIndexList list = selectionModel->selectedIndexes();
-        if (list.size()) {
-            // QTableView is configured to select only rows.
-            // So, list[0] - IP address.
-            d->ui.tableViewAddresses->edit(list[0]);
-        }
-    }
+    const int row = d->model.appendRoute();
+    d->ui.tableViewAddresses->selectRow(row);
+    d->ui.tableViewAddresses->edit(d->model.index(row, RouteTableModel::AddressColumn));
 }
 
 void IpV6RoutesWidget::removeRoute()
 {
     QItemSelectionModel * selectionModel = d->ui.tableViewAddresses->selectionModel();
     if (selectionModel->hasSelection()) {
-        QModelIndexList indexes = selectionModel->selectedIndexes();
-        d->model.takeRow(indexes[0].row());
+        // Remove selected rows from the bottom so that the row numbers stay valid,
+        // adjacent rows are removed at once
+        QList<int> rows;
+        Q_FOREACH (const QModelIndex &index, selectionModel->selectedRows()) {
+            rows << index.row();
+        }
+        std::sort(rows.begin(), rows.end(), std::greater<int>());
+
+        int i = 0;
+        while (i < rows.count()) {
+            int count = 1;
+            while (i + count < rows.count() && rows.at(i + count) == rows.at(i) - count) {
+                ++count;
+            }
+            d->model.removeRows(rows.at(i) - count + 1, count);
+            i += count;
+        }
     }
-    d->ui.pushButtonRemove->setEnabled(false);
+    d->ui.pushButtonRemove->setEnabled(d->ui.tableViewAddresses->selectionModel()->hasSelection());
 }
 
 void IpV6RoutesWidget::selectionChanged(const QItemSelection & selected)
@@ -189,23 +166,44 @@ void IpV6RoutesWidget::selectionChanged(const QItemSelection & selected)
 
 extern quint32 suggestNetmask(Q_IPV6ADDR ip);
 
-void IpV6RoutesWidget::tableViewItemChanged(QStandardItem *item)
+void IpV6RoutesWidget::routeChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
 {
-    if (item->text().isEmpty()) {
+    if (topLeft != bottomRight || topLeft.column() != RouteTableModel::AddressColumn) {
         return;
     }
 
-    const int column = item->column();
-    if (column == 0) { // ip
-        int row = item->row();
+    const QString address = topLeft.data().toString();
+    if (address.isEmpty() || d->model.hasInvalidValues(topLeft)) {
+        return;
+    }
 
-        QStandardItem *netmaskItem = d->model.item(row, column + 1); // netmask
-        if (netmaskItem && netmaskItem->text().isEmpty()) {
-            QHostAddress addr(item->text());
-            quint32 netmask = suggestNetmask(addr.toIPv6Address());
-            if (netmask) {
-                netmaskItem->setText(QString::number(netmask,10));
-            }
+    const QModelIndex netmaskIndex = topLeft.sibling(topLeft.row(), RouteTableModel::NetmaskColumn);
+    if (netmaskIndex.data().toString().isEmpty()) {
+        QHostAddress addr(address);
+        quint32 netmask = suggestNetmask(addr.toIPv6Address());
+        if (netmask) {
+            d->model.setData(netmaskIndex, QString::number(netmask,10));
+        }
+    }
+}
+
+void IpV6RoutesWidget::updateOkButton()
+{
+    d->ui.buttonBox->button(QDialogButtonBox::Ok)->setEnabled(!d->model.hasInvalidValues());
+}
+
+void IpV6RoutesWidget::pasteRoutes()
+{
+    QList<int> invalidLines;
+    d->model.importRoutes(QApplication::clipboard()->text(), &invalidLines);
+
+    if (!invalidLines.isEmpty()) {
+        QStringList lines;
+        Q_FOREACH (int line, invalidLines.mid(0, 10)) {
+            lines << QString::number(line);
         }
+        KMessageBox::sorry(this, i18np("Line %2 could not be imported as a route.",
+                                       "%1 lines could not be imported as routes, for example: %2",
+                                       invalidLines.count(), lines.join(QStringLiteral(", "))));
     }
 }
@@ -26,8 +26,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <NetworkManagerQt/IpConfig>
 
-class QStandardItem;
 class QItemSelection;
+class QModelIndex;
 
 class IpV6RoutesWidget : public QDialog
 {
@@ -51,7 +51,12 @@ private Q_SLOTS:
      * Update remove IP button depending on if there is a selection
      */
     void selectionChanged(const QItemSelection &);
-    void tableViewItemChanged(QStandardItem *);
+    void routeChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void updateOkButton();
+    /**
+     * Append routes from the clipboard, one route per line
+     */
+    void pasteRoutes();
 
 private:
     class Private;
@@ -0,0 +1,426 @@
+/*
+    Copyright 2026 agent <agent@local>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "routetablemodel.h"
+#include "simpleipv4addressvalidator.h"
+#include "simpleipv6addressvalidator.h"
+
+#include <QStringList>
+#include <QtEndian>
+
+#include <KColorScheme>
+#include <KLocalizedString>
+
+RouteTableModel::RouteTableModel(QAbstractSocket::NetworkLayerProtocol protocol, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_protocol(protocol)
+{
+}
+
+RouteTableModel::~RouteTableModel()
+{
+}
+
+int RouteTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_routes.count();
+}
+
+int RouteTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 4;
+}
+
+QVariant RouteTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_routes.count()) {
+        return QVariant();
+    }
+
+    if (m_invalidTexts.contains(index)) {
+        switch (role) {
+        case Qt::DisplayRole:
+        case Qt::EditRole:
+            return m_invalidTexts.value(index);
+        case Qt::ForegroundRole:
+            return KColorScheme(QPalette::Active).foreground(KColorScheme::NegativeText);
+        case Qt::ToolTipRole:
+            return index.column() == MetricColumn ? i18n("The metric has to be a non-negative number")
+                                                  : i18n("This is not a complete address");
+        }
+    }
+
+    if (role != Qt::DisplayRole && role != Qt::EditRole) {
+        return QVariant();
+    }
+
+    const Route &route = m_routes.at(index.row());
+    switch (index.column()) {
+    case AddressColumn:
+        return (route.flags & HasAddress) ? addressToString(route.address) : QString();
+    case NetmaskColumn:
+        if (!(route.flags & HasNetmask)) {
+            return QString();
+        }
+        if (m_protocol == QAbstractSocket::IPv4Protocol) {
+            return QHostAddress(route.netmask).toString();
+        }
+        return QString::number(route.netmask);
+    case NextHopColumn:
+        return (route.flags & HasNextHop) ? addressToString(route.nextHop) : QString();
+    case MetricColumn:
+        return (route.flags & HasMetric) ? QString::number(route.metric) : QString();
+    }
+
+    return QVariant();
+}
+
+bool RouteTableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || index.row() >= m_routes.count() || role != Qt::EditRole) {
+        return false;
+    }
+
+    Route &route = m_routes[index.row()];
+    const QString text = value.toString().trimmed();
+    quint8 flag = 0;
+    bool ok = true;
+
+    switch (index.column()) {
+    case AddressColumn:
+        flag = HasAddress;
+        ok = text.isEmpty() || parseAddress(text, &route.address);
+        break;
+    case NetmaskColumn:
+        flag = HasNetmask;
+        ok = text.isEmpty() || parseNetmask(text, &route.netmask);
+        break;
+    case NextHopColumn:
+        flag = HasNextHop;
+        ok = text.isEmpty() || parseAddress(text, &route.nextHop);
+        break;
+    case MetricColumn:
+        flag = HasMetric;
+        if (!text.isEmpty()) {
+            const uint metric = text.toUInt(&ok);
+            if (ok) {
+                route.metric = metric;
+            }
+        }
+        break;
+    default:
+        return false;
+    }
+
+    // Incomplete values keep the text visible and flagged until they are fixed,
+    // the route keeps its previous value in the meantime
+    if (!ok) {
+        m_invalidTexts.insert(index, text);
+        Q_EMIT dataChanged(index, index);
+        return true;
+    }
+
+    m_invalidTexts.remove(index);
+    if (text.isEmpty()) {
+        route.flags &= ~flag;
+    } else {
+        route.flags |= flag;
+    }
+
+    Q_EMIT dataChanged(index, index);
+    return true;
+}
+
+QVariant RouteTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    const bool ipv4 = (m_protocol == QAbstractSocket::IPv4Protocol);
+    switch (section) {
+    case AddressColumn:
+        return ipv4 ? i18nc("Header text for IPv4 address", "Address") : i18nc("Header text for IPv6 address", "Address");
+    case NetmaskColumn:
+        return ipv4 ? i18nc("Header text for IPv4 netmask", "Netmask") : i18nc("Header text for IPv6 netmask", "Netmask");
+    case NextHopColumn:
+        return ipv4 ? i18nc("Header text for IPv4 gateway", "Gateway") : i18nc("Header text for IPv6 gateway", "Gateway");
+    case MetricColumn:
+        return ipv4 ? i18nc("Header text for IPv4 route metric", "Metric") : i18nc("Header text for IPv6 route metric", "Metric");
+    }
+
+    return QVariant();
+}
+
+Qt::ItemFlags RouteTableModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
+}
+
+bool RouteTableModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > m_routes.count()) {
+        return false;
+    }
+
+    beginRemoveRows(parent, row, row + count - 1);
+    QMap<QPersistentModelIndex, QString>::iterator it = m_invalidTexts.begin();
+    while (it != m_invalidTexts.end()) {
+        if (it.key().row() >= row && it.key().row() < row + count) {
+            it = m_invalidTexts.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_routes.remove(row, count);
+    endRemoveRows();
+
+    return true;
+}
+
+void RouteTableModel::setRoutes(const QList<NetworkManager::IpRoute> &routes)
+{
+    beginResetModel();
+
+    m_invalidTexts.clear();
+    m_routes.clear();
+    m_routes.reserve(routes.count());
+
+    Q_FOREACH (const NetworkManager::IpRoute &ipRoute, routes) {
+        Route route = Route();
+        route.flags = HasMetric;
+        route.metric = ipRoute.metric();
+
+        if (m_protocol == QAbstractSocket::IPv4Protocol) {
+            if (!ipRoute.ip().isNull()) {
+                qToBigEndian(ipRoute.ip().toIPv4Address(), route.address.c);
+                route.flags |= HasAddress;
+            }
+            if (!ipRoute.netmask().isNull()) {
+                route.netmask = ipRoute.netmask().toIPv4Address();
+                route.flags |= HasNetmask;
+            }
+            if (!ipRoute.nextHop().isNull()) {
+                qToBigEndian(ipRoute.nextHop().toIPv4Address(), route.nextHop.c);
+                route.flags |= HasNextHop;
+            }
+        } else {
+            if (!ipRoute.ip().isNull()) {
+                route.address = ipRoute.ip().toIPv6Address();
+                route.flags |= HasAddress;
+            }
+            if (ipRoute.prefixLength() >= 0) {
+                route.netmask = ipRoute.prefixLength();
+                route.flags |= HasNetmask;
+            }
+            if (!ipRoute.nextHop().isNull()) {
+                route.nextHop = ipRoute.nextHop().toIPv6Address();
+                route.flags |= HasNextHop;
+            }
+        }
+
+        m_routes << route;
+    }
+
+    endResetModel();
+}
+
+QList<NetworkManager::IpRoute> RouteTableModel::routes() const
+{
+    QList<NetworkManager::IpRoute> list;
+    list.reserve(m_routes.count());
+
+    Q_FOREACH (const Route &route, m_routes) {
+        NetworkManager::IpRoute ipRoute;
+        if (route.flags & HasAddress) {
+            ipRoute.setIp(toHostAddress(route.address));
+        }
+        if (m_protocol == QAbstractSocket::IPv4Protocol) {
+            if (route.flags & HasNetmask) {
+                ipRoute.setNetmask(QHostAddress(route.netmask));
+            }
+        } else {
+            ipRoute.setPrefixLength((route.flags & HasNetmask) ? route.netmask : 0);
+        }
+        ipRoute.setNextHop((route.flags & HasNextHop) ? toHostAddress(route.nextHop) : QHostAddress());
+        ipRoute.setMetric((route.flags & HasMetric) ? route.metric : 0);
+
+        list << ipRoute;
+    }
+
+    return list;
+}
+
+int RouteTableModel::appendRoute()
+{
+    const int row = m_routes.count();
+
+    beginInsertRows(QModelIndex(), row, row);
+    m_routes << Route();
+    endInsertRows();
+
+    return row;
+}
+
+int RouteTableModel::importRoutes(const QString &text, QList<int> *invalidLines)
+{
+    QVector<Route> imported;
+    int lineNumber = 0;
+
+    Q_FOREACH (const QStringRef &rawLine, text.splitRef(QLatin1Char('\n'))) {
+        ++lineNumber;
+
+        const QStringRef line = rawLine.trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+
+        // Split the line into at most five fields
+        QStringRef fields[5];
+        int fieldCount = 0;
+        int start = -1;
+        for (int i = 0; i <= line.size() && fieldCount < 5; ++i) {
+            const bool separator = (i == line.size() || line.at(i).isSpace() || line.at(i) == QLatin1Char(','));
+            if (separator && start != -1) {
+                fields[fieldCount++] = line.mid(start, i - start);
+                start = -1;
+            } else if (!separator && start == -1) {
+                start = i;
+            }
+        }
+
+        Route route = Route();
+        bool ok = fieldCount > 0 && fieldCount < 5;
+        int field = 1;
+
+        if (ok) {
+            const int slash = fields[0].indexOf(QLatin1Char('/'));
+            if (slash != -1) {
+                // The validator checks the prefix range too
+                int prefix = 0;
+                const QValidator::State state = (m_protocol == QAbstractSocket::IPv4Protocol)
+                    ? SimpleIpV4AddressValidator::checkAddress(fields[0], SimpleIpV4AddressValidator::WithCidr, &prefix)
+                    : SimpleIpV6AddressValidator::checkAddress(fields[0], SimpleIpV6AddressValidator::WithCidr, &prefix);
+                ok = state == QValidator::Acceptable && parseAddress(fields[0].left(slash).toString(), &route.address);
+                if (ok && m_protocol == QAbstractSocket::IPv4Protocol) {
+                    route.netmask = prefix ? (0xffffffffu << (32 - prefix)) : 0;
+                } else if (ok) {
+                    route.netmask = prefix;
+                }
+                route.flags |= HasAddress | HasNetmask;
+            } else {
+                ok = parseAddress(fields[0].toString(), &route.address);
+                route.flags |= HasAddress;
+                if (ok && fieldCount > 1) {
+                    ok = parseNetmask(fields[1].toString(), &route.netmask);
+                    route.flags |= HasNetmask;
+                    field = 2;
+                }
+            }
+        }
+
+        if (ok && field < fieldCount) {
+            ok = parseAddress(fields[field++].toString(), &route.nextHop);
+            route.flags |= HasNextHop;
+        }
+
+        if (ok && field < fieldCount) {
+            route.metric = fields[field++].toUInt(&ok);
+            route.flags |= HasMetric;
+        }
+
+        if (!ok || field < fieldCount) {
+            if (invalidLines) {
+                *invalidLines << lineNumber;
+            }
+            continue;
+        }
+
+        imported << route;
+    }
+
+    if (!imported.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_routes.count(), m_routes.count() + imported.count() - 1);
+        m_routes << imported;
+        endInsertRows();
+    }
+
+    return imported.count();
+}
+
+bool RouteTableModel::hasInvalidValues(const QModelIndex &index) const
+{
+    return index.isValid() ? m_invalidTexts.contains(index) : !m_invalidTexts.isEmpty();
+}
+
+bool RouteTableModel::parseAddress(const QString &text, Q_IPV6ADDR *address) const
+{
+    QHostAddress hostAddress;
+    if (!hostAddress.setAddress(text) || hostAddress.protocol() != m_protocol) {
+        return false;
+    }
+
+    if (m_protocol == QAbstractSocket::IPv4Protocol) {
+        *address = Q_IPV6ADDR();
+        qToBigEndian(hostAddress.toIPv4Address(), address->c);
+    } else {
+        *address = hostAddress.toIPv6Address();
+    }
+
+    return true;
+}
+
+bool RouteTableModel::parseNetmask(const QString &text, quint32 *netmask) const
+{
+    if (m_protocol == QAbstractSocket::IPv4Protocol) {
+        QHostAddress hostAddress;
+        if (!hostAddress.setAddress(text) || hostAddress.protocol() != QAbstractSocket::IPv4Protocol) {
+            return false;
+        }
+        *netmask = hostAddress.toIPv4Address();
+        return true;
+    }
+
+    bool ok = false;
+    const uint prefix = text.toUInt(&ok);
+    if (!ok || prefix > 128) {
+        return false;
+    }
+    *netmask = prefix;
+    return true;
+}
+
+QString RouteTableModel::addressToString(const Q_IPV6ADDR &address) const
+{
+    return toHostAddress(address).toString();
+}
+
+QHostAddress RouteTableModel::toHostAddress(const Q_IPV6ADDR &address) const
+{
+    if (m_protocol == QAbstractSocket::IPv4Protocol) {
+        return QHostAddress(qFromBigEndian<quint32>(address.c));
+    }
+
+    return QHostAddress(address);
+}
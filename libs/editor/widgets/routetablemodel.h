@@ -0,0 +1,105 @@
+/*
+    Copyright 2026 agent <agent@local>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLASMA_NM_ROUTE_TABLE_MODEL_H
+#define PLASMA_NM_ROUTE_TABLE_MODEL_H
+
+#include <QAbstractTableModel>
+#include <QHostAddress>
+#include <QMap>
+#include <QPersistentModelIndex>
+#include <QVector>
+
+#include <NetworkManagerQt/IpConfig>
+
+/**
+ * Table of static routes which keeps only the parsed values of every route,
+ * cell texts are created when a cell is painted or edited
+ */
+class Q_DECL_EXPORT RouteTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column {
+        AddressColumn = 0,
+        NetmaskColumn, // netmask for IPv4, prefix length for IPv6
+        NextHopColumn,
+        MetricColumn
+    };
+
+    explicit RouteTableModel(QAbstractSocket::NetworkLayerProtocol protocol, QObject *parent = nullptr);
+    virtual ~RouteTableModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) Q_DECL_OVERRIDE;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+    Qt::ItemFlags flags(const QModelIndex &index) const Q_DECL_OVERRIDE;
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) Q_DECL_OVERRIDE;
+
+    void setRoutes(const QList<NetworkManager::IpRoute> &routes);
+    QList<NetworkManager::IpRoute> routes() const;
+
+    // Appends an empty route and returns its row
+    int appendRoute();
+
+    /**
+     * @brief importRoutes appends routes parsed from text, one route per line in the form
+     * "address/prefix [gateway [metric]]" or "address netmask [gateway [metric]]",
+     * fields may be separated by spaces, tabs or commas
+     * @param invalidLines set to the numbers of lines which couldn't be parsed
+     * @return number of imported routes
+     */
+    int importRoutes(const QString &text, QList<int> *invalidLines = nullptr);
+
+    // Whether the cell, or any cell for an invalid index, shows text which couldn't be parsed
+    bool hasInvalidValues(const QModelIndex &index = QModelIndex()) const;
+
+private:
+    enum RouteFlag {
+        HasAddress = 0x1,
+        HasNetmask = 0x2,
+        HasNextHop = 0x4,
+        HasMetric = 0x8
+    };
+
+    struct Route {
+        // IPv4 addresses are kept in the first four bytes
+        Q_IPV6ADDR address;
+        Q_IPV6ADDR nextHop;
+        quint32 netmask;
+        quint32 metric;
+        quint8 flags;
+    };
+
+    bool parseAddress(const QString &text, Q_IPV6ADDR *address) const;
+    bool parseNetmask(const QString &text, quint32 *netmask) const;
+    QString addressToString(const Q_IPV6ADDR &address) const;
+    QHostAddress toHostAddress(const Q_IPV6ADDR &address) const;
+
+    QAbstractSocket::NetworkLayerProtocol m_protocol;
+    QVector<Route> m_routes;
+    // Rejected cell texts, shown in place of the parsed value until the cell is fixed,
+    // not a hash as the keys change when rows above them are removed
+    QMap<QPersistentModelIndex, QString> m_invalidTexts;
+};
+
+#endif // PLASMA_NM_ROUTE_TABLE_MODEL_H
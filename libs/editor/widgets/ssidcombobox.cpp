@@ -22,22 +22,34 @@
 #include "ssidcombobox.h"
 #include "uiutils.h"
 
+#include <QAbstractItemView>
+#include <QSignalBlocker>
+#include <QTimer>
+
 #include <NetworkManagerQt/Manager>
 #include <NetworkManagerQt/WirelessDevice>
 
 #include <KLocalizedString>
 
+#include <algorithm>
+
+#define SSID_REFRESH_INTERVAL 1000
+
 bool signalCompare(const NetworkManager::WirelessNetwork::Ptr & one, const NetworkManager::WirelessNetwork::Ptr & two)
 {
     return one->signalStrength() > two->signalStrength();
 }
 
 SsidComboBox::SsidComboBox(QWidget *parent) :
-    KComboBox(parent)
+    KComboBox(parent), m_refreshTimer(new QTimer(this))
 {
     setEditable(true);
     setInsertPolicy(QComboBox::NoInsert);
 
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(SSID_REFRESH_INTERVAL);
+    connect(m_refreshTimer, &QTimer::timeout, this, &SsidComboBox::refresh);
+
     connect(this, &SsidComboBox::editTextChanged, this, &SsidComboBox::slotEditTextChanged);
     connect(this, static_cast<void (SsidComboBox::*)(int)>(&SsidComboBox::activated), this, &SsidComboBox::slotCurrentIndexChanged);
 }
@@ -69,33 +81,28 @@ void SsidComboBox::init(const QString &ssid)
 
     // qCDebug(PLASMA_NM) << "Initial ssid:" << m_initialSsid;
 
-    QList<NetworkManager::WirelessNetwork::Ptr> networks;
+    m_networks.clear();
 
     Q_FOREACH (const NetworkManager::Device::Ptr & device, NetworkManager::networkInterfaces()) {
         if (device->type() == NetworkManager::Device::Wifi) {
             NetworkManager::WirelessDevice::Ptr wifiDevice = device.objectCast<NetworkManager::WirelessDevice>();
 
+            connect(wifiDevice.data(), &NetworkManager::WirelessDevice::networkAppeared, this, &SsidComboBox::slotNetworkAppeared, Qt::UniqueConnection);
+            connect(wifiDevice.data(), &NetworkManager::WirelessDevice::networkDisappeared, this, &SsidComboBox::slotNetworkDisappeared, Qt::UniqueConnection);
+
             Q_FOREACH (const NetworkManager::WirelessNetwork::Ptr & newNetwork, wifiDevice->networks()) {
-                bool found = false;
-                Q_FOREACH (const NetworkManager::WirelessNetwork::Ptr & existingNetwork, networks) {
-                    if (newNetwork->ssid() == existingNetwork->ssid()) {
-                        if (newNetwork->signalStrength() > existingNetwork->signalStrength()) {
-                            networks.removeOne(existingNetwork);
-                            break;
-                        } else {
-                            found = true;
-                            break;
-                        }
-                    }
-                }
-                if (!found) {
-                    networks << newNetwork;
+                watchNetwork(newNetwork);
+
+                NetworkManager::WirelessNetwork::Ptr existingNetwork = m_networks.value(newNetwork->ssid());
+                if (!existingNetwork || newNetwork->signalStrength() > existingNetwork->signalStrength()) {
+                    m_networks.insert(newNetwork->ssid(), newNetwork);
                 }
             }
         }
     }
 
-    qSort(networks.begin(), networks.end(), signalCompare);
+    QList<NetworkManager::WirelessNetwork::Ptr> networks = m_networks.values();
+    std::sort(networks.begin(), networks.end(), signalCompare);
     addSsidsToCombo(networks);
 
     int index = findData(m_initialSsid);
@@ -108,16 +115,91 @@ void SsidComboBox::init(const QString &ssid)
     setEditText(m_initialSsid);
 }
 
-void SsidComboBox::addSsidsToCombo(const QList<NetworkManager::WirelessNetwork::Ptr> &networks)
+void SsidComboBox::slotNetworkAppeared(const QString &ssid)
 {
-    QList<NetworkManager::WirelessDevice::Ptr> wifiDevices;
+    NetworkManager::WirelessDevice *wifiDevice = qobject_cast<NetworkManager::WirelessDevice *>(sender());
+    if (wifiDevice) {
+        NetworkManager::WirelessNetwork::Ptr network = wifiDevice->findNetwork(ssid);
+        if (network) {
+            watchNetwork(network);
+        }
+    }
 
-    Q_FOREACH (const NetworkManager::Device::Ptr & dev, NetworkManager::networkInterfaces()) {
-        if (dev->type() == NetworkManager::Device::Wifi) {
-            wifiDevices << dev.objectCast<NetworkManager::WirelessDevice>();
+    updateNetwork(ssid);
+}
+
+void SsidComboBox::slotNetworkDisappeared(const QString &ssid)
+{
+    updateNetwork(ssid);
+}
+
+void SsidComboBox::slotSignalStrengthChanged()
+{
+    NetworkManager::WirelessNetwork *network = qobject_cast<NetworkManager::WirelessNetwork *>(sender());
+    if (network) {
+        updateNetwork(network->ssid());
+    }
+}
+
+void SsidComboBox::watchNetwork(const NetworkManager::WirelessNetwork::Ptr &network)
+{
+    connect(network.data(), &NetworkManager::WirelessNetwork::signalStrengthChanged, this, &SsidComboBox::slotSignalStrengthChanged, Qt::UniqueConnection);
+}
+
+void SsidComboBox::updateNetwork(const QString &ssid)
+{
+    NetworkManager::WirelessNetwork::Ptr bestNetwork;
+
+    Q_FOREACH (const NetworkManager::Device::Ptr & device, NetworkManager::networkInterfaces()) {
+        if (device->type() == NetworkManager::Device::Wifi) {
+            NetworkManager::WirelessNetwork::Ptr network = device.objectCast<NetworkManager::WirelessDevice>()->findNetwork(ssid);
+            if (network && (!bestNetwork || network->signalStrength() > bestNetwork->signalStrength())) {
+                bestNetwork = network;
+            }
         }
     }
 
+    if (bestNetwork) {
+        m_networks.insert(ssid, bestNetwork);
+    } else if (!m_networks.remove(ssid)) {
+        return;
+    }
+
+    if (!m_refreshTimer->isActive()) {
+        m_refreshTimer->start();
+    }
+}
+
+void SsidComboBox::refresh()
+{
+    // Don't move items under the mouse cursor
+    if (view()->isVisible()) {
+        m_refreshTimer->start();
+        return;
+    }
+
+    const QString text = currentText();
+    const QString currentSsid = itemData(currentIndex()).toString();
+
+    QSignalBlocker blocker(this);
+
+    clear();
+
+    QList<NetworkManager::WirelessNetwork::Ptr> networks = m_networks.values();
+    std::sort(networks.begin(), networks.end(), signalCompare);
+    addSsidsToCombo(networks);
+
+    if (findData(m_initialSsid) == -1) {
+        insertItem(0, m_initialSsid, m_initialSsid);
+    }
+
+    const int index = findData(currentSsid);
+    setCurrentIndex(index == -1 ? 0 : index);
+    setEditText(text);
+}
+
+void SsidComboBox::addSsidsToCombo(const QList<NetworkManager::WirelessNetwork::Ptr> &networks)
+{
     bool empty = true;
 
     Q_FOREACH (const NetworkManager::WirelessNetwork::Ptr & network, networks) {
@@ -127,22 +209,23 @@ void SsidComboBox::addSsidsToCombo(const QList<NetworkManager::WirelessNetwork::
             continue;
         }
 
-        Q_FOREACH (const NetworkManager::WirelessDevice::Ptr & wifiDev, wifiDevices) {
-            if (wifiDev->findNetwork(network->ssid()) == network) {
-                if (!empty) {
-                    insertSeparator(count());
-                }
-                empty = false;
-
-                NetworkManager::WirelessSecurityType security = NetworkManager::findBestWirelessSecurity(wifiDev->wirelessCapabilities(), true, (wifiDev->mode() == NetworkManager::WirelessDevice::Adhoc), accessPoint->capabilities(), accessPoint->wpaFlags(), accessPoint->rsnFlags());
-                if (security != NetworkManager::UnknownSecurity && security != NetworkManager::NoneSecurity) {
-                    const QString text = i18n("%1 (%2%)\nSecurity: %3\nFrequency: %4 Mhz", accessPoint->ssid(), network->signalStrength(), UiUtils::labelFromWirelessSecurity(security), accessPoint->frequency());
-                    addItem(QIcon::fromTheme("object-locked"), text, accessPoint->ssid());
-                } else {
-                    const QString text = i18n("%1 (%2%)\nSecurity: Insecure\nFrequency: %3 Mhz", accessPoint->ssid(), network->signalStrength(), accessPoint->frequency());
-                    addItem(QIcon::fromTheme("object-unlocked"), text, accessPoint->ssid());
-                }
-            }
+        NetworkManager::WirelessDevice::Ptr wifiDev = NetworkManager::findNetworkInterface(network->device()).objectCast<NetworkManager::WirelessDevice>();
+        if (!wifiDev) {
+            continue;
+        }
+
+        if (!empty) {
+            insertSeparator(count());
+        }
+        empty = false;
+
+        NetworkManager::WirelessSecurityType security = NetworkManager::findBestWirelessSecurity(wifiDev->wirelessCapabilities(), true, (wifiDev->mode() == NetworkManager::WirelessDevice::Adhoc), accessPoint->capabilities(), accessPoint->wpaFlags(), accessPoint->rsnFlags());
+        if (security != NetworkManager::UnknownSecurity && security != NetworkManager::NoneSecurity) {
+            const QString text = i18n("%1 (%2%)\nSecurity: %3\nFrequency: %4 Mhz", accessPoint->ssid(), network->signalStrength(), UiUtils::labelFromWirelessSecurity(security), accessPoint->frequency());
+            addItem(QIcon::fromTheme("object-locked"), text, accessPoint->ssid());
+        } else {
+            const QString text = i18n("%1 (%2%)\nSecurity: Insecure\nFrequency: %3 Mhz", accessPoint->ssid(), network->signalStrength(), accessPoint->frequency());
+            addItem(QIcon::fromTheme("object-unlocked"), text, accessPoint->ssid());
         }
     }
 }
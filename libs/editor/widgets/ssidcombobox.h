@@ -22,10 +22,14 @@
 #ifndef PLASMA_NM_SSIDCOMBOBOX_H
 #define PLASMA_NM_SSIDCOMBOBOX_H
 
+#include <QHash>
+
 #include <KComboBox>
 
 #include <NetworkManagerQt/WirelessNetwork>
 
+class QTimer;
+
 class Q_DECL_EXPORT SsidComboBox : public KComboBox
 {
     Q_OBJECT
@@ -42,10 +46,25 @@ Q_SIGNALS:
 private Q_SLOTS:
     void slotEditTextChanged(const QString &text);
     void slotCurrentIndexChanged(int);
+    void slotNetworkAppeared(const QString &ssid);
+    void slotNetworkDisappeared(const QString &ssid);
+    void slotSignalStrengthChanged();
+    void refresh();
 
 private:
     void addSsidsToCombo(const QList<NetworkManager::WirelessNetwork::Ptr> &networks);
+    /**
+     * @brief updateNetwork finds the strongest network with given SSID on all wireless devices
+     * and schedules an update of the list
+     */
+    void updateNetwork(const QString &ssid);
+    void watchNetwork(const NetworkManager::WirelessNetwork::Ptr &network);
+
     QString m_initialSsid;
+    // Strongest network for every visible SSID
+    QHash<QString, NetworkManager::WirelessNetwork::Ptr> m_networks;
+    // Coalesces list updates caused by scan results
+    QTimer *m_refreshTimer;
 };
 
 #endif // PLASMA_NM_SSIDCOMBOBOX_H
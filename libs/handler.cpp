@@ -21,6 +21,7 @@
 #include "handler.h"
 #include "connectioneditordialog.h"
 #include "uiutils.h"
+#include "vpnpluginregistry.h"
 #include "debug.h"
 
 #include <NetworkManagerQt/Manager>
@@ -43,14 +44,14 @@
 
 #include <QDBusError>
 #include <QDBusPendingReply>
+#include <QDBusServiceWatcher>
 #include <QIcon>
+#include <QSet>
 
 #include <KNotification>
 #include <KLocalizedString>
 #include <KUser>
 #include <KProcess>
-#include <KService>
-#include <KServiceTypeTrader>
 #include <KWindowSystem>
 #include <KIconLoader>
 #include <KWallet/Wallet>
@@ -59,11 +60,27 @@
 #define AGENT_PATH "/modules/networkmanagement"
 #define AGENT_IFACE "org.kde.plasmanetworkmanagement"
 
+#define BLUEZ_SERVICE "org.bluez"
+#define BLUEZ_ADAPTER_IFACE "org.bluez.Adapter1"
+
+#define AIRPLANE_MODE_TIMEOUT 5000
+
+// Milliseconds of the system wide monotonic clock, the activation tracer in kded uses the same clock
+static qint64 monotonicTime()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer.msecsSinceReference();
+}
+
 
 Handler::Handler(QObject *parent)
     : QObject(parent)
     , m_tmpWirelessEnabled(NetworkManager::isWirelessEnabled())
     , m_tmpWwanEnabled(NetworkManager::isWwanEnabled())
+    , m_airplaneModeInProgress(false)
+    , m_airplaneModeTimer(new QTimer(this))
+    , m_lastBatchId(0)
 {
     initKdedModule();
     QDBusConnection::sessionBus().connect(QStringLiteral(AGENT_SERVICE),
@@ -71,14 +88,82 @@ Handler::Handler(QObject *parent)
                                             QStringLiteral(AGENT_IFACE),
                                             QStringLiteral("registered"),
                                             this, SLOT(initKdedModule()));
+
+    qDBusRegisterMetaType< QMap<QDBusObjectPath, NMVariantMapMap > >();
+
+    QDBusServiceWatcher *bluezWatcher = new QDBusServiceWatcher(QStringLiteral(BLUEZ_SERVICE), QDBusConnection::systemBus(),
+                                                                QDBusServiceWatcher::WatchForRegistration | QDBusServiceWatcher::WatchForUnregistration, this);
+    connect(bluezWatcher, &QDBusServiceWatcher::serviceRegistered, this, &Handler::bluetoothServiceRegistered);
+    connect(bluezWatcher, &QDBusServiceWatcher::serviceUnregistered, this, &Handler::bluetoothServiceUnregistered);
+
+    QDBusConnection::systemBus().connect(QStringLiteral(BLUEZ_SERVICE),
+                                         QStringLiteral("/"),
+                                         QStringLiteral("org.freedesktop.DBus.ObjectManager"),
+                                         QStringLiteral("InterfacesAdded"),
+                                         this, SLOT(bluetoothInterfacesAdded(QDBusObjectPath,NMVariantMapMap)));
+    QDBusConnection::systemBus().connect(QStringLiteral(BLUEZ_SERVICE),
+                                         QStringLiteral("/"),
+                                         QStringLiteral("org.freedesktop.DBus.ObjectManager"),
+                                         QStringLiteral("InterfacesRemoved"),
+                                         this, SLOT(bluetoothInterfacesRemoved(QDBusObjectPath,QStringList)));
+    // Empty path matches PropertiesChanged of every object, the arg0 match leaves only adapters
+    // so property changes of devices (RSSI, battery, ...) don't wake us up
+    QDBusConnection::systemBus().connect(QStringLiteral(BLUEZ_SERVICE),
+                                         QString(),
+                                         QStringLiteral("org.freedesktop.DBus.Properties"),
+                                         QStringLiteral("PropertiesChanged"),
+                                         QStringList() << QStringLiteral(BLUEZ_ADAPTER_IFACE),
+                                         QString(),
+                                         this, SLOT(bluetoothPropertiesChanged(QString,QVariantMap,QStringList,QDBusMessage)));
+    initBluetoothAdapters();
+
+    m_airplaneModeTimer->setSingleShot(true);
+    m_airplaneModeTimer->setInterval(AIRPLANE_MODE_TIMEOUT);
+    connect(m_airplaneModeTimer, &QTimer::timeout, this, &Handler::airplaneModeTimeout);
+    connect(NetworkManager::notifier(), &NetworkManager::Notifier::wirelessEnabledChanged,
+            this, [this] (bool enabled) {
+                airplaneModeRadioChanged(QStringLiteral("wireless"), enabled);
+            });
+    connect(NetworkManager::notifier(), &NetworkManager::Notifier::wwanEnabledChanged,
+            this, [this] (bool enabled) {
+                airplaneModeRadioChanged(QStringLiteral("wwan"), enabled);
+            });
 }
 
 Handler::~Handler()
 {
 }
 
+QStringList Handler::pendingConnections() const
+{
+    QStringList connections;
+    Q_FOREACH (QDBusPendingCallWatcher *watcher, m_pendingOperations) {
+        const QString connection = watcher->property("connectionPath").toString();
+        if (!connection.isEmpty() && !connections.contains(connection)) {
+            connections << connection;
+        }
+    }
+    return connections;
+}
+
+bool Handler::isConnectionPending(const QString& connection) const
+{
+    return pendingConnections().contains(connection);
+}
+
+bool Handler::airplaneModeInProgress() const
+{
+    return m_airplaneModeInProgress;
+}
+
 void Handler::activateConnection(const QString& connection, const QString& device, const QString& specificObject)
 {
+    const QString key = operationKey(Handler::ActivateConnection, connection, device);
+    if (isOperationPending(key)) {
+        qCDebug(PLASMA_NM) << "Activation of" << connection << "is already in progress";
+        return;
+    }
+
     NetworkManager::Connection::Ptr con = NetworkManager::findConnection(connection);
 
     if (!con) {
@@ -90,10 +175,8 @@ void Handler::activateConnection(const QString& connection, const QString& devic
         NetworkManager::VpnSetting::Ptr vpnSetting = con->settings()->setting(NetworkManager::Setting::Vpn).staticCast<NetworkManager::VpnSetting>();
         if (vpnSetting) {
             qCDebug(PLASMA_NM) << "Checking VPN" << con->name() << "type:" << vpnSetting->serviceType();
-            // get the list of supported VPN service types
-            const KService::List services = KServiceTypeTrader::self()->query("PlasmaNetworkManagement/VpnUiPlugin",
-                                                                              QString::fromLatin1("[X-NetworkManager-Services]=='%1'").arg(vpnSetting->serviceType()));
-            if (services.isEmpty()) {
+            // check whether a plugin for this VPN service type is installed
+            if (!VpnPluginRegistry::self()->hasPlugin(vpnSetting->serviceType())) {
                 qCWarning(PLASMA_NM) << "VPN" << vpnSetting->serviceType() << "not found, skipping";
                 KNotification *notification = new KNotification("MissingVpnPlugin", KNotification::CloseOnTimeout, this);
                 notification->setComponentName("networkmanagement");
@@ -129,15 +212,53 @@ void Handler::activateConnection(const QString& connection, const QString& devic
     }
 #endif
 
+    traceActivation(QStringLiteral("traceActivationRequested"), QVariantList() << connection << monotonicTime());
+
     QDBusPendingReply<QDBusObjectPath> reply = NetworkManager::activateConnection(connection, device, specificObject);
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
     watcher->setProperty("action", Handler::ActivateConnection);
     watcher->setProperty("connection", con->name());
     connect(watcher, &QDBusPendingCallWatcher::finished, this, &Handler::replyFinished);
+    addPendingOperation(key, connection, watcher);
+}
+
+uint Handler::activateConnections(const QStringList& connections)
+{
+    const uint batch = startBatchOperation(Handler::ActivateConnection);
+
+    // Activating a connection again would only interrupt it
+    QSet<QString> activeUuids;
+    Q_FOREACH (const NetworkManager::ActiveConnection::Ptr &active, NetworkManager::activeConnections()) {
+        activeUuids << active->uuid();
+    }
+
+    Q_FOREACH (const QString &connection, connections) {
+        NetworkManager::Connection::Ptr con = NetworkManager::findConnection(connection);
+        if (!con) {
+            addBatchError(batch, connection, i18n("Connection not found"));
+            continue;
+        }
+        if (activeUuids.contains(con->uuid())) {
+            continue;
+        }
+        // Connections can be of different types, "/" lets NetworkManager pick a suitable device
+        // for each of them the same way it does for autoconnect
+        addBatchCall(batch, connection, NetworkManager::activateConnection(connection, QStringLiteral("/"), QStringLiteral("/")));
+    }
+
+    finishBatchOperation(batch);
+    return batch;
 }
 
 void Handler::addAndActivateConnection(const QString& device, const QString& specificObject, const QString& password)
 {
+    // Without this a double click would create two identical connections
+    const QString key = operationKey(Handler::AddAndActivateConnection, specificObject, device);
+    if (isOperationPending(key)) {
+        qCDebug(PLASMA_NM) << "Connection for" << specificObject << "is already being added";
+        return;
+    }
+
     NetworkManager::AccessPoint::Ptr ap;
     NetworkManager::WirelessDevice::Ptr wifiDev;
     Q_FOREACH (const NetworkManager::Device::Ptr & dev, NetworkManager::networkInterfaces()) {
@@ -231,6 +352,7 @@ void Handler::addAndActivateConnection(const QString& device, const QString& spe
         watcher->setProperty("action", Handler::AddAndActivateConnection);
         watcher->setProperty("connection", settings->name());
         connect(watcher, &QDBusPendingCallWatcher::finished, this, &Handler::replyFinished);
+        addPendingOperation(key, QString(), watcher);
     }
 
     settings.clear();
@@ -247,6 +369,12 @@ void Handler::addConnection(const NMVariantMapMap& map)
 
 void Handler::deactivateConnection(const QString& connection, const QString& device)
 {
+    const QString key = operationKey(Handler::DeactivateConnection, connection, device);
+    if (isOperationPending(key)) {
+        qCDebug(PLASMA_NM) << "Deactivation of" << connection << "is already in progress";
+        return;
+    }
+
     NetworkManager::Connection::Ptr con = NetworkManager::findConnection(connection);
 
     if (!con) {
@@ -271,7 +399,33 @@ void Handler::deactivateConnection(const QString& connection, const QString& dev
 
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
     watcher->setProperty("action", Handler::DeactivateConnection);
+    watcher->setProperty("connection", con->name());
     connect(watcher, &QDBusPendingCallWatcher::finished, this, &Handler::replyFinished);
+    addPendingOperation(key, connection, watcher);
+}
+
+uint Handler::deactivateConnections(const QStringList& connections)
+{
+    const uint batch = startBatchOperation(Handler::DeactivateConnection);
+
+    QSet<QString> uuids;
+    Q_FOREACH (const QString &connection, connections) {
+        NetworkManager::Connection::Ptr con = NetworkManager::findConnection(connection);
+        if (con) {
+            uuids << con->uuid();
+        } else {
+            addBatchError(batch, connection, i18n("Connection not found"));
+        }
+    }
+
+    Q_FOREACH (const NetworkManager::ActiveConnection::Ptr &active, NetworkManager::activeConnections()) {
+        if (uuids.contains(active->uuid()) && active->connection()) {
+            addBatchCall(batch, active->connection()->path(), NetworkManager::deactivateConnection(active->path()));
+        }
+    }
+
+    finishBatchOperation(batch);
+    return batch;
 }
 
 void Handler::disconnectAll()
@@ -283,79 +437,215 @@ void Handler::disconnectAll()
 
 void Handler::enableAirplaneMode(bool enable)
 {
+    if (m_airplaneModeInProgress) {
+        qCDebug(PLASMA_NM) << "Airplane mode change is already in progress";
+        return;
+    }
+
+    m_airplaneMode.enable = enable;
+    m_airplaneMode.wirelessEnabled = NetworkManager::isWirelessEnabled();
+    m_airplaneMode.wwanEnabled = NetworkManager::isWwanEnabled();
+    m_airplaneMode.bluetoothAdapters = m_bluetoothAdaptersPowered;
+    m_airplaneMode.pending.clear();
+    m_airplaneMode.radios.clear();
+    m_airplaneMode.timings.clear();
+    m_airplaneMode.timer.start();
+    m_airplaneModeInProgress = true;
+    Q_EMIT airplaneModeInProgressChanged();
+
+    // All radios are switched at once, confirmations are collected in airplaneModeRadioChanged()
     if (enable) {
-        m_tmpWirelessEnabled = NetworkManager::isWirelessEnabled();
-        m_tmpWwanEnabled = NetworkManager::isWwanEnabled();
+        m_tmpWirelessEnabled = m_airplaneMode.wirelessEnabled;
+        m_tmpWwanEnabled = m_airplaneMode.wwanEnabled;
         enableBluetooth(false);
-        enableWireless(false);
-        enableWwan(false);
+        setAirplaneModeRadio(QStringLiteral("wireless"), false);
+        setAirplaneModeRadio(QStringLiteral("wwan"), false);
     } else {
         enableBluetooth(true);
         if (m_tmpWirelessEnabled) {
-            enableWireless(true);
+            setAirplaneModeRadio(QStringLiteral("wireless"), true);
         }
         if (m_tmpWwanEnabled) {
-            enableWwan(true);
+            setAirplaneModeRadio(QStringLiteral("wwan"), true);
         }
     }
+
+    if (m_airplaneMode.pending.isEmpty()) {
+        finishAirplaneMode(true);
+    } else {
+        m_airplaneModeTimer->start();
+    }
 }
 
 void Handler::enableBluetooth(bool enable)
 {
-    qDBusRegisterMetaType< QMap<QDBusObjectPath, NMVariantMapMap > >();
+    // Adapter states are cached, so all the changes are sent at once without querying BlueZ first
+    QHash<QString, bool>::const_iterator it = m_bluetoothAdaptersPowered.constBegin();
+    for (; it != m_bluetoothAdaptersPowered.constEnd(); ++it) {
+        if (!enable) {
+            m_bluetoothAdapters.insert(it.key(), it.value());
+            setAirplaneModeRadio(it.key(), false);
+        } else if (m_bluetoothAdapters.value(it.key())) {
+            setAirplaneModeRadio(it.key(), true);
+        }
+    }
+}
+
+void Handler::setAirplaneModeRadio(const QString& radio, bool enabled)
+{
+    bool currentState;
+    if (radio == QLatin1String("wireless")) {
+        currentState = NetworkManager::isWirelessEnabled();
+    } else if (radio == QLatin1String("wwan")) {
+        currentState = NetworkManager::isWwanEnabled();
+    } else {
+        currentState = m_bluetoothAdaptersPowered.value(radio);
+    }
+
+    if (currentState == enabled) {
+        return;
+    }
 
-    QDBusMessage message = QDBusMessage::createMethodCall("org.bluez", "/", "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+    if (m_airplaneModeInProgress) {
+        m_airplaneMode.pending.insert(radio, enabled);
+        m_airplaneMode.radios << radio;
+    }
+
+    if (radio == QLatin1String("wireless")) {
+        NetworkManager::setWirelessEnabled(enabled);
+    } else if (radio == QLatin1String("wwan")) {
+        NetworkManager::setWwanEnabled(enabled);
+    } else {
+        setBluetoothAdapterPowered(radio, enabled);
+    }
+}
+
+void Handler::airplaneModeRadioChanged(const QString& radio, bool enabled)
+{
+    if (!m_airplaneModeInProgress || !m_airplaneMode.pending.contains(radio) || m_airplaneMode.pending.value(radio) != enabled) {
+        return;
+    }
+
+    m_airplaneMode.pending.remove(radio);
+    m_airplaneMode.timings.insert(radio, m_airplaneMode.timer.elapsed());
+
+    if (m_airplaneMode.pending.isEmpty()) {
+        finishAirplaneMode(true);
+    }
+}
+
+void Handler::airplaneModeTimeout()
+{
+    qCWarning(PLASMA_NM) << "Radios" << m_airplaneMode.pending.keys() << "didn't confirm airplane mode change in time";
+    rollbackAirplaneMode();
+}
+
+void Handler::rollbackAirplaneMode()
+{
+    m_airplaneModeTimer->stop();
+    m_airplaneMode.pending.clear();
+
+    // Restore every radio we touched, even the ones which confirmed the change already
+    Q_FOREACH (const QString &radio, m_airplaneMode.radios) {
+        if (radio == QLatin1String("wireless")) {
+            NetworkManager::setWirelessEnabled(m_airplaneMode.wirelessEnabled);
+        } else if (radio == QLatin1String("wwan")) {
+            NetworkManager::setWwanEnabled(m_airplaneMode.wwanEnabled);
+        } else if (m_airplaneMode.bluetoothAdapters.contains(radio)) {
+            setBluetoothAdapterPowered(radio, m_airplaneMode.bluetoothAdapters.value(radio));
+        }
+    }
+
+    finishAirplaneMode(false);
+}
+
+void Handler::finishAirplaneMode(bool success)
+{
+    m_airplaneModeTimer->stop();
+    m_airplaneModeInProgress = false;
+
+    Q_EMIT airplaneModeFinished(m_airplaneMode.enable, success, m_airplaneMode.timer.elapsed(), m_airplaneMode.timings);
+    Q_EMIT airplaneModeInProgressChanged();
+}
+
+void Handler::initBluetoothAdapters()
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral(BLUEZ_SERVICE), QStringLiteral("/"), QStringLiteral("org.freedesktop.DBus.ObjectManager"), QStringLiteral("GetManagedObjects"));
     QDBusPendingReply<QMap<QDBusObjectPath, NMVariantMapMap> > reply = QDBusConnection::systemBus().asyncCall(message);
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
     connect(watcher, &QDBusPendingCallWatcher::finished,
-        [this, enable] (QDBusPendingCallWatcher *watcher) {
+        [this] (QDBusPendingCallWatcher *watcher) {
             QDBusPendingReply<QMap<QDBusObjectPath, NMVariantMapMap> > reply = *watcher;
             if (reply.isValid()) {
-                Q_FOREACH (const QDBusObjectPath &path, reply.value().keys()) {
-                    const QString objPath = path.path();
-                    qCDebug(PLASMA_NM) << "inspecting path" << objPath;
-                    const QStringList interfaces = reply.value().value(path).keys();
-                    qCDebug(PLASMA_NM) << "interfaces:" << interfaces;
-                    if (interfaces.contains("org.bluez.Adapter1")) {
-                        // We need to check previous state first
-                        if (!enable) {
-                            QDBusMessage message = QDBusMessage::createMethodCall("org.bluez", objPath, "org.freedesktop.DBus.Properties", "Get");
-                            QList<QVariant> arguments;
-                            arguments << QLatin1Literal("org.bluez.Adapter1");
-                            arguments << QLatin1Literal("Powered");
-                            message.setArguments(arguments);
-                            QDBusPendingReply<QVariant> getReply = QDBusConnection::systemBus().asyncCall(message);
-                            QDBusPendingCallWatcher *getWatcher = new QDBusPendingCallWatcher(getReply, this);
-                                connect(getWatcher, &QDBusPendingCallWatcher::finished,
-                                    [this, objPath] (QDBusPendingCallWatcher *watcher) {
-                                        QDBusPendingReply<QVariant> reply = *watcher;
-                                        if (reply.isValid()) {
-                                            m_bluetoothAdapters.insert(objPath, reply.value().toBool());
-                                            QDBusMessage message = QDBusMessage::createMethodCall("org.bluez", objPath, "org.freedesktop.DBus.Properties", "Set");
-                                            QList<QVariant> arguments;
-                                            arguments << QLatin1Literal("org.bluez.Adapter1");
-                                            arguments << QLatin1Literal("Powered");
-                                            arguments << QVariant::fromValue(QDBusVariant(QVariant(false)));
-                                            message.setArguments(arguments);
-                                            QDBusConnection::systemBus().asyncCall(message);
-                                        }
-
-                                    });
-                            getWatcher->deleteLater();
-                        } else if (enable && m_bluetoothAdapters.value(objPath)) {
-                            QDBusMessage message = QDBusMessage::createMethodCall("org.bluez", objPath, "org.freedesktop.DBus.Properties", "Set");
-                            QList<QVariant> arguments;
-                            arguments << QLatin1Literal("org.bluez.Adapter1");
-                            arguments << QLatin1Literal("Powered");
-                            arguments << QVariant::fromValue(QDBusVariant(QVariant(enable)));
-                            message.setArguments(arguments);
-                            QDBusConnection::systemBus().asyncCall(message);
-                        }
-                    }
+                const QMap<QDBusObjectPath, NMVariantMapMap> objects = reply.value();
+                QMap<QDBusObjectPath, NMVariantMapMap>::const_iterator it = objects.constBegin();
+                for (; it != objects.constEnd(); ++it) {
+                    bluetoothInterfacesAdded(it.key(), it.value());
                 }
             }
+            watcher->deleteLater();
         });
-    watcher->deleteLater();
+}
+
+void Handler::setBluetoothAdapterPowered(const QString& adapter, bool powered)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral(BLUEZ_SERVICE), adapter, QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("Set"));
+    QList<QVariant> arguments;
+    arguments << QLatin1Literal(BLUEZ_ADAPTER_IFACE);
+    arguments << QLatin1Literal("Powered");
+    arguments << QVariant::fromValue(QDBusVariant(QVariant(powered)));
+    message.setArguments(arguments);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished,
+        [this, adapter] (QDBusPendingCallWatcher *watcher) {
+            QDBusPendingReply<> reply = *watcher;
+            if (reply.isError()) {
+                qCWarning(PLASMA_NM) << "Failed to change power state of bluetooth adapter" << adapter << reply.error().message();
+                if (m_airplaneModeInProgress && m_airplaneMode.pending.contains(adapter)) {
+                    rollbackAirplaneMode();
+                }
+            }
+            watcher->deleteLater();
+        });
+}
+
+void Handler::bluetoothInterfacesAdded(const QDBusObjectPath& path, const NMVariantMapMap& interfaces)
+{
+    if (interfaces.contains(QStringLiteral(BLUEZ_ADAPTER_IFACE))) {
+        const bool powered = interfaces.value(QStringLiteral(BLUEZ_ADAPTER_IFACE)).value(QStringLiteral("Powered")).toBool();
+        qCDebug(PLASMA_NM) << "Bluetooth adapter" << path.path() << "powered:" << powered;
+        m_bluetoothAdaptersPowered.insert(path.path(), powered);
+    }
+}
+
+void Handler::bluetoothInterfacesRemoved(const QDBusObjectPath& path, const QStringList& interfaces)
+{
+    if (interfaces.contains(QStringLiteral(BLUEZ_ADAPTER_IFACE))) {
+        m_bluetoothAdaptersPowered.remove(path.path());
+    }
+}
+
+void Handler::bluetoothPropertiesChanged(const QString& interface, const QVariantMap& properties, const QStringList& invalidated, const QDBusMessage& message)
+{
+    Q_UNUSED(invalidated);
+
+    if (interface != QLatin1String(BLUEZ_ADAPTER_IFACE) || !properties.contains(QStringLiteral("Powered"))) {
+        return;
+    }
+
+    const bool powered = properties.value(QStringLiteral("Powered")).toBool();
+    m_bluetoothAdaptersPowered.insert(message.path(), powered);
+    airplaneModeRadioChanged(message.path(), powered);
+}
+
+void Handler::bluetoothServiceRegistered()
+{
+    initBluetoothAdapters();
+}
+
+void Handler::bluetoothServiceUnregistered()
+{
+    m_bluetoothAdaptersPowered.clear();
 }
 
 void Handler::enableNetworking(bool enable)
@@ -375,6 +665,12 @@ void Handler::enableWwan(bool enable)
 
 void Handler::removeConnection(const QString& connection)
 {
+    const QString key = operationKey(Handler::RemoveConnection, connection, QString());
+    if (isOperationPending(key)) {
+        qCDebug(PLASMA_NM) << "Removal of" << connection << "is already in progress";
+        return;
+    }
+
     NetworkManager::Connection::Ptr con = NetworkManager::findConnection(connection);
 
     if (!con || con->uuid().isEmpty()) {
@@ -395,6 +691,35 @@ void Handler::removeConnection(const QString& connection)
     watcher->setProperty("action", Handler::RemoveConnection);
     watcher->setProperty("connection", con->name());
     connect(watcher, &QDBusPendingCallWatcher::finished, this, &Handler::replyFinished);
+    addPendingOperation(key, QString(), watcher);
+}
+
+uint Handler::removeConnections(const QStringList& connections)
+{
+    const uint batch = startBatchOperation(Handler::RemoveConnection);
+
+    const QSet<QString> paths = connections.toSet();
+    QSet<QString> masters;
+    Q_FOREACH (const QString &connection, paths) {
+        NetworkManager::Connection::Ptr con = NetworkManager::findConnection(connection);
+        if (!con || con->uuid().isEmpty()) {
+            qCWarning(PLASMA_NM) << "Not possible to remove connection " << connection;
+            addBatchError(batch, connection, i18n("Connection not found"));
+            continue;
+        }
+        masters << con->uuid();
+        addBatchCall(batch, connection, con->remove());
+    }
+
+    // Remove slave connections, walking the list of connections only once for the whole batch
+    Q_FOREACH (const NetworkManager::Connection::Ptr &connection, NetworkManager::listConnections()) {
+        if (!paths.contains(connection->path()) && masters.contains(connection->settings()->master())) {
+            addBatchCall(batch, connection->path(), connection->remove());
+        }
+    }
+
+    finishBatchOperation(batch);
+    return batch;
 }
 
 void Handler::updateConnection(const NetworkManager::Connection::Ptr& connection, const NMVariantMapMap& map)
@@ -406,16 +731,40 @@ void Handler::updateConnection(const NetworkManager::Connection::Ptr& connection
     connect(watcher, &QDBusPendingCallWatcher::finished, this, &Handler::replyFinished);
 }
 
+uint Handler::updateConnections(const QMap<QString, NMVariantMapMap>& connections)
+{
+    const uint batch = startBatchOperation(Handler::UpdateConnection);
+
+    QMap<QString, NMVariantMapMap>::const_iterator it = connections.constBegin();
+    for (; it != connections.constEnd(); ++it) {
+        NetworkManager::Connection::Ptr con = NetworkManager::findConnection(it.key());
+        if (!con) {
+            qCWarning(PLASMA_NM) << "Not possible to update connection " << it.key();
+            addBatchError(batch, it.key(), i18n("Connection not found"));
+            continue;
+        }
+        addBatchCall(batch, it.key(), con->update(it.value()));
+    }
+
+    finishBatchOperation(batch);
+    return batch;
+}
+
 void Handler::requestScan()
 {
     Q_FOREACH (NetworkManager::Device::Ptr device, NetworkManager::networkInterfaces()) {
         if (device->type() == NetworkManager::Device::Wifi) {
             NetworkManager::WirelessDevice::Ptr wifiDevice = device.objectCast<NetworkManager::WirelessDevice>();
             if (wifiDevice) {
+                const QString key = operationKey(Handler::RequestScan, QString(), wifiDevice->uni());
+                if (isOperationPending(key)) {
+                    continue;
+                }
                 QDBusPendingReply<> reply = wifiDevice->requestScan();
                 QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
                 watcher->setProperty("action", Handler::RequestScan);
                 connect(watcher, &QDBusPendingCallWatcher::finished, this, &Handler::replyFinished);
+                addPendingOperation(key, QString(), watcher);
             }
         }
     }
@@ -430,9 +779,157 @@ void Handler::initKdedModule()
     QDBusConnection::sessionBus().send(initMsg);
 }
 
+QString Handler::operationKey(Handler::HandlerAction action, const QString& connection, const QString& device) const
+{
+    return QString::number(action) + QLatin1Char('|') + connection + QLatin1Char('|') + device;
+}
+
+bool Handler::isOperationPending(const QString& key) const
+{
+    return m_pendingOperations.contains(key);
+}
+
+void Handler::addPendingOperation(const QString& key, const QString& connection, QDBusPendingCallWatcher* watcher)
+{
+    watcher->setProperty("operationKey", key);
+    watcher->setProperty("connectionPath", connection);
+    m_pendingOperations.insert(key, watcher);
+
+    if (!connection.isEmpty()) {
+        Q_EMIT pendingConnectionsChanged();
+    }
+}
+
+uint Handler::startBatchOperation(Handler::HandlerAction action)
+{
+    BatchOperation operation;
+    operation.action = action;
+    operation.finished = 0;
+    operation.total = 0;
+
+    const uint batch = ++m_lastBatchId;
+    m_batchOperations.insert(batch, operation);
+    return batch;
+}
+
+void Handler::addBatchCall(uint batch, const QString& item, const QDBusPendingCall& call)
+{
+    m_batchOperations[batch].total++;
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    watcher->setProperty("batch", batch);
+    watcher->setProperty("item", item);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &Handler::batchReplyFinished);
+}
+
+void Handler::addBatchError(uint batch, const QString& item, const QString& error)
+{
+    BatchOperation &operation = m_batchOperations[batch];
+    operation.total++;
+    operation.finished++;
+    operation.errors.insert(item, error);
+}
+
+void Handler::finishBatchOperation(uint batch)
+{
+    const BatchOperation operation = m_batchOperations.value(batch);
+    Q_EMIT batchOperationProgress(batch, operation.action, operation.finished, operation.total, operation.errors);
+
+    // Nothing was sent or every item failed already, there won't be any reply to wait for
+    if (operation.finished == operation.total) {
+        notifyBatchErrors(operation);
+        m_batchOperations.remove(batch);
+    }
+}
+
+void Handler::notifyBatchErrors(const BatchOperation& operation)
+{
+    if (operation.errors.isEmpty()) {
+        return;
+    }
+
+    // Report all failures of the batch with a single notification
+    QString eventId;
+    QString title;
+    switch (operation.action) {
+        case Handler::ActivateConnection:
+            eventId = QStringLiteral("FailedToActivateConnection");
+            title = i18np("Failed to activate %1 connection", "Failed to activate %1 connections", operation.errors.count());
+            break;
+        case Handler::DeactivateConnection:
+            eventId = QStringLiteral("FailedToDeactivateConnection");
+            title = i18np("Failed to deactivate %1 connection", "Failed to deactivate %1 connections", operation.errors.count());
+            break;
+        case Handler::UpdateConnection:
+            eventId = QStringLiteral("FailedToUpdateConnection");
+            title = i18np("Failed to update %1 connection", "Failed to update %1 connections", operation.errors.count());
+            break;
+        default:
+            eventId = QStringLiteral("FailedToRemoveConnection");
+            title = i18np("Failed to remove %1 connection", "Failed to remove %1 connections", operation.errors.count());
+            break;
+    }
+    KNotification *notification = new KNotification(eventId, KNotification::CloseOnTimeout, this);
+    notification->setTitle(title);
+    notification->setComponentName("networkmanagement");
+    notification->setText(operation.errors.constBegin().value().toString());
+    notification->setPixmap(QIcon::fromTheme("dialog-warning").pixmap(KIconLoader::SizeHuge));
+    notification->sendEvent();
+}
+
+void Handler::batchReplyFinished(QDBusPendingCallWatcher* watcher)
+{
+    const uint batch = watcher->property("batch").toUInt();
+    if (!m_batchOperations.contains(batch)) {
+        watcher->deleteLater();
+        return;
+    }
+
+    BatchOperation &operation = m_batchOperations[batch];
+    operation.finished++;
+
+    QDBusPendingReply<> reply = *watcher;
+    if (reply.isError()) {
+        operation.errors.insert(watcher->property("item").toString(), reply.error().message());
+    }
+
+    Q_EMIT batchOperationProgress(batch, operation.action, operation.finished, operation.total, operation.errors);
+
+    if (operation.finished == operation.total) {
+        notifyBatchErrors(operation);
+        m_batchOperations.remove(batch);
+    }
+
+    watcher->deleteLater();
+}
+
+void Handler::traceActivation(const QString& method, const QVariantList& arguments)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral(AGENT_SERVICE),
+                                                          QStringLiteral(AGENT_PATH),
+                                                          QStringLiteral(AGENT_IFACE),
+                                                          method);
+    message.setArguments(arguments);
+    QDBusConnection::sessionBus().send(message);
+}
+
 void Handler::replyFinished(QDBusPendingCallWatcher * watcher)
 {
+    const QString key = watcher->property("operationKey").toString();
+    if (!key.isEmpty() && m_pendingOperations.value(key) == watcher) {
+        m_pendingOperations.remove(key);
+        if (!watcher->property("connectionPath").toString().isEmpty()) {
+            Q_EMIT pendingConnectionsChanged();
+        }
+    }
+
     QDBusPendingReply<> reply = *watcher;
+    if (watcher->property("action").toUInt() == Handler::ActivateConnection) {
+        traceActivation(QStringLiteral("traceActivationReplied"), QVariantList() << watcher->property("connectionPath").toString()
+                                                                                 << monotonicTime()
+                                                                                 << reply.error().message());
+    }
+
     if (reply.isError() || !reply.isValid()) {
         KNotification *notification = 0;
         QString error = reply.error().message();
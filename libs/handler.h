@@ -22,6 +22,9 @@
 #define PLASMA_NM_HANDLER_H
 
 #include <QDBusInterface>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
 
 #include <NetworkManagerQt/Connection>
 #if WITH_MODEMMANAGER_SUPPORT
@@ -32,6 +35,8 @@
 class Q_DECL_EXPORT Handler : public QObject
 {
 Q_OBJECT
+Q_PROPERTY(QStringList pendingConnections READ pendingConnections NOTIFY pendingConnectionsChanged)
+Q_PROPERTY(bool airplaneModeInProgress READ airplaneModeInProgress NOTIFY airplaneModeInProgressChanged)
 
 public:
     enum HandlerAction {
@@ -47,6 +52,20 @@ public:
     explicit Handler(QObject* parent = 0);
     virtual ~Handler();
 
+    /**
+     * Returns d-bus paths of connections with an activation or deactivation request still in flight
+     */
+    QStringList pendingConnections() const;
+    /**
+     * Returns true when an activation or deactivation request for given connection is still in flight
+     * @connection - d-bus path of the connection
+     */
+    Q_INVOKABLE bool isConnectionPending(const QString &connection) const;
+    /**
+     * Returns true while radios are being switched by enableAirplaneMode()
+     */
+    bool airplaneModeInProgress() const;
+
 public Q_SLOTS:
     /**
      * Activates given connection
@@ -55,6 +74,15 @@ public Q_SLOTS:
      * @specificParameter - d-bus path of the specific object you want to use for this activation, i.e access point
      */
     void activateConnection(const QString &connection, const QString &device, const QString &specificParameter);
+    /**
+     * Activates given connections, all requests are sent at once without waiting for replies
+     * @connections - d-bus paths of the connections you want to activate
+     * @return identifier of the batch reported by batchOperationProgress()
+     *
+     * No device is passed, NetworkManager picks one for each connection. Connections which
+     * are already active are skipped.
+     */
+    uint activateConnections(const QStringList &connections);
     /**
      * Adds and activates a new wireless connection
      * @device - d-bus path of the wireless device where the connection should be activated
@@ -77,10 +105,21 @@ public Q_SLOTS:
      * @device - d-bus path of the connection where the connection is activated
      */
     void deactivateConnection(const QString &connection, const QString &device);
+    /**
+     * Deactivates all active instances of given connections, all requests are sent at once
+     * @connections - d-bus paths of the connections you want to deactivate
+     * @return identifier of the batch reported by batchOperationProgress()
+     */
+    uint deactivateConnections(const QStringList &connections);
     /**
      * Disconnects all connections
      */
     void disconnectAll();
+    /**
+     * Switches all radios at once and waits until each of them confirms the change,
+     * when some radio fails or doesn't confirm the change in time all radios are restored
+     * @enable - whether airplane mode should be enabled
+     */
     void enableAirplaneMode(bool enable);
     void enableNetworking(bool enable);
     void enableWireless(bool enable);
@@ -91,33 +130,119 @@ public Q_SLOTS:
      * @connection - d-bus path of the connection you want to edit
      */
     void removeConnection(const QString & connection);
+    /**
+     * Removes given connections together with their slave connections, all requests are sent at once
+     * @connections - d-bus paths of the connections you want to remove
+     * @return identifier of the batch reported by batchOperationProgress()
+     */
+    uint removeConnections(const QStringList &connections);
     /**
      * Updates given connection
      * @connection - connection which should be updated
      * @map - NMVariantMapMap with new connection settings
      */
     void updateConnection(const NetworkManager::Connection::Ptr &connection, const NMVariantMapMap &map);
+    /**
+     * Updates given connections, all requests are sent at once
+     * @connections - map of d-bus paths of the connections and their new settings
+     * @return identifier of the batch reported by batchOperationProgress()
+     */
+    uint updateConnections(const QMap<QString, NMVariantMapMap> &connections);
     void requestScan();
 
+Q_SIGNALS:
+    void pendingConnectionsChanged();
+    /**
+     * Emitted once a batch operation is started and then for every reply which arrives
+     * @batch - identifier returned when the batch was started
+     * @action - HandlerAction performed by the batch
+     * @finished - number of items which already got a reply
+     * @total - number of items in the batch
+     * @errors - d-bus paths of the items which failed so far mapped to the error message,
+     * items which couldn't be sent at all are counted as finished and failed right away
+     */
+    void batchOperationProgress(uint batch, int action, int finished, int total, const QVariantMap &errors);
+    void airplaneModeInProgressChanged();
+    /**
+     * Emitted when switching of radios started by enableAirplaneMode() is finished
+     * @enabled - requested airplane mode state
+     * @success - false when the change was rolled back
+     * @elapsed - milliseconds the whole change took
+     * @timings - milliseconds each radio (wireless, wwan or path of a bluetooth adapter) needed to confirm the change
+     */
+    void airplaneModeFinished(bool enabled, bool success, qint64 elapsed, const QVariantMap &timings);
+
 private Q_SLOTS:
     void initKdedModule();
+    void bluetoothInterfacesAdded(const QDBusObjectPath &path, const NMVariantMapMap &interfaces);
+    void bluetoothInterfacesRemoved(const QDBusObjectPath &path, const QStringList &interfaces);
+    void bluetoothPropertiesChanged(const QString &interface, const QVariantMap &properties, const QStringList &invalidated, const QDBusMessage &message);
+    void bluetoothServiceRegistered();
+    void bluetoothServiceUnregistered();
+    void airplaneModeRadioChanged(const QString &radio, bool enabled);
+    void airplaneModeTimeout();
     void replyFinished(QDBusPendingCallWatcher *watcher);
+    void batchReplyFinished(QDBusPendingCallWatcher *watcher);
 #if WITH_MODEMMANAGER_SUPPORT
     void unlockRequiredChanged(MMModemLock modemLock);
 #endif
 
 private:
+    struct BatchOperation {
+        HandlerAction action;
+        int finished;
+        int total;
+        QVariantMap errors;
+    };
+
+    struct AirplaneModeTransaction {
+        bool enable;
+        bool wirelessEnabled;
+        bool wwanEnabled;
+        QHash<QString, bool> bluetoothAdapters;
+        // Radios which didn't confirm the change yet, mapped to the requested state
+        QHash<QString, bool> pending;
+        // Radios which were asked to change their state
+        QStringList radios;
+        QVariantMap timings;
+        QElapsedTimer timer;
+    };
+
     bool m_tmpWirelessEnabled;
     bool m_tmpWwanEnabled;
+    bool m_airplaneModeInProgress;
+    AirplaneModeTransaction m_airplaneMode;
+    QTimer *m_airplaneModeTimer;
 #if WITH_MODEMMANAGER_SUPPORT
     QString m_tmpConnectionPath;
 #endif
     QString m_tmpConnectionUuid;
     QString m_tmpDevicePath;
     QString m_tmpSpecificPath;
+    // Powered state of bluetooth adapters before airplane mode was enabled
     QMap<QString, bool> m_bluetoothAdapters;
+    // Current powered state of bluetooth adapters, kept up to date from BlueZ signals
+    QHash<QString, bool> m_bluetoothAdaptersPowered;
+    // Requests waiting for a reply, keyed by (action, connection, device)
+    QHash<QString, QDBusPendingCallWatcher*> m_pendingOperations;
+    QHash<uint, BatchOperation> m_batchOperations;
+    uint m_lastBatchId;
 
     void enableBluetooth(bool enable);
+    void initBluetoothAdapters();
+    void setBluetoothAdapterPowered(const QString &adapter, bool powered);
+    void setAirplaneModeRadio(const QString &radio, bool enabled);
+    void rollbackAirplaneMode();
+    void finishAirplaneMode(bool success);
+    QString operationKey(HandlerAction action, const QString &connection, const QString &device) const;
+    bool isOperationPending(const QString &key) const;
+    void addPendingOperation(const QString &key, const QString &connection, QDBusPendingCallWatcher *watcher);
+    void traceActivation(const QString &method, const QVariantList &arguments);
+    uint startBatchOperation(HandlerAction action);
+    void addBatchCall(uint batch, const QString &item, const QDBusPendingCall &call);
+    void addBatchError(uint batch, const QString &item, const QString &error);
+    void notifyBatchErrors(const BatchOperation &operation);
+    void finishBatchOperation(uint batch);
 };
 
 #endif // PLASMA_NM_HANDLER_H
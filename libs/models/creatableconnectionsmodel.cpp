@@ -21,10 +21,9 @@
 #include "creatableconnectionsmodel.h"
 
 #include "configuration.h"
+#include "vpnpluginregistry.h"
 
 #include <KLocalizedString>
-#include <KService>
-#include <KServiceTypeTrader>
 
 CreatableConnectionItem::CreatableConnectionItem(const QString &typeName, const QString &typeSection,
                                                  const QString &description, const QString &icon,
@@ -201,22 +200,11 @@ CreatableConnectionsModel::CreatableConnectionsModel(QObject *parent)
         m_list << connectionItem;
     }
 
-    KService::List services = KServiceTypeTrader::self()->query("PlasmaNetworkManagement/VpnUiPlugin");
-
-    std::sort(services.begin(), services.end(), [] (const KService::Ptr &left, const KService::Ptr &right)
-    {
-        return QString::localeAwareCompare(left->name(), right->name()) <= 0;
-    });
-
-    Q_FOREACH (const KService::Ptr & service, services) {
-        const QString vpnType = service->property("X-NetworkManager-Services", QVariant::String).toString();
-        const QString vpnSubType = service->property("X-NetworkManager-Services-Subtype", QVariant::String).toString();
-        const QString vpnDescription = service->property("Comment", QVariant::String).toString();
-
-        connectionItem = new CreatableConnectionItem(service->name(), i18n("VPN connections"),
-                                                     vpnDescription, QStringLiteral("network-vpn"),
+    Q_FOREACH (const VpnPluginRegistry::PluginInfo &plugin, VpnPluginRegistry::self()->plugins()) {
+        connectionItem = new CreatableConnectionItem(plugin.name, i18n("VPN connections"),
+                                                     plugin.comment, QStringLiteral("network-vpn"),
                                                      NetworkManager::ConnectionSettings::Vpn,
-                                                     vpnType, vpnSubType, false);
+                                                     plugin.serviceType, plugin.subType, false);
         m_list << connectionItem;
     }
 
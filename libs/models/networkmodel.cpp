@@ -30,6 +30,8 @@
 #include <NetworkManagerQt/Settings>
 #include <NetworkManagerQt/Utils>
 
+#include <QDBusConnection>
+
 NetworkModel::NetworkModel(QObject* parent)
     : QAbstractListModel(parent)
 {
@@ -182,6 +184,13 @@ void NetworkModel::initializeSignals()
     connect(NetworkManager::notifier(), &NetworkManager::Notifier::deviceAdded, this, &NetworkModel::deviceAdded, Qt::UniqueConnection);
     connect(NetworkManager::notifier(), &NetworkManager::Notifier::deviceRemoved, this, &NetworkModel::deviceRemoved, Qt::UniqueConnection);
     connect(NetworkManager::notifier(), &NetworkManager::Notifier::statusChanged, this, &NetworkModel::statusChanged, Qt::UniqueConnection);
+
+    // Activation timings are recorded by the kded module
+    QDBusConnection::sessionBus().connect(QStringLiteral("org.kde.kded5"),
+                                          QStringLiteral("/modules/networkmanagement"),
+                                          QStringLiteral("org.kde.plasmanetworkmanagement"),
+                                          QStringLiteral("activationTraceFinished"),
+                                          this, SLOT(activationTraceFinished(QVariantMap)));
 }
 
 void NetworkModel::initializeSignals(const NetworkManager::ActiveConnection::Ptr& activeConnection)
@@ -533,6 +542,18 @@ void NetworkModel::accessPointSignalStrengthChanged(int signal)
     }
 }
 
+void NetworkModel::activationTraceFinished(const QVariantMap& trace)
+{
+    if (!trace.value(QStringLiteral("success")).toBool()) {
+        return;
+    }
+
+    Q_FOREACH (NetworkModelItem * item, m_list.returnItems(NetworkItemsList::Uuid, trace.value(QStringLiteral("uuid")).toString())) {
+        item->setActivationTime(trace.value(QStringLiteral("total")).toLongLong(), trace.value(QStringLiteral("auth")).toLongLong());
+        updateItem(item);
+    }
+}
+
 void NetworkModel::activeConnectionAdded(const QString& activeConnection)
 {
     NetworkManager::ActiveConnection::Ptr activeCon = NetworkManager::findActiveConnection(activeConnection);
@@ -79,6 +79,7 @@ public Q_SLOTS:
 
 private Q_SLOTS:
     void accessPointSignalStrengthChanged(int signal);
+    void activationTraceFinished(const QVariantMap &trace);
     void activeConnectionAdded(const QString& activeConnection);
     void activeConnectionRemoved(const QString& activeConnection);
     void activeConnectionStateChanged(NetworkManager::ActiveConnection::State state);
@@ -61,6 +61,8 @@ NetworkModelItem::NetworkModelItem(QObject* parent)
     , m_slave(false)
     , m_type(NetworkManager::ConnectionSettings::Unknown)
     , m_vpnState(NetworkManager::VpnConnection::Unknown)
+    , m_activationTime(0)
+    , m_activationAuthTime(0)
 {
 }
 
@@ -78,6 +80,8 @@ NetworkModelItem::NetworkModelItem(const NetworkModelItem* item, QObject* parent
     , m_type(item->type())
     , m_uuid(item->uuid())
     , m_vpnState(NetworkManager::VpnConnection::Unknown)
+    , m_activationTime(0)
+    , m_activationAuthTime(0)
 {
 }
 
@@ -105,6 +109,12 @@ void NetworkModelItem::setConnectionPath(const QString& path)
     m_connectionPath = path;
 }
 
+void NetworkModelItem::setActivationTime(qint64 total, qint64 auth)
+{
+    m_activationTime = total;
+    m_activationAuthTime = auth;
+}
+
 NetworkManager::ActiveConnection::State NetworkModelItem::connectionState() const
 {
     return m_connectionState;
@@ -559,4 +569,8 @@ void NetworkModelItem::updateDetails()
         }
     }
 #endif
+
+    if (m_activationTime > 0 && m_connectionState == NetworkManager::ActiveConnection::Activated) {
+        m_details << i18n("Last activation") << i18n("%1 ms, %2 ms in authentication", m_activationTime, m_activationAuthTime);
+    }
 }
@@ -51,6 +51,13 @@ public:
 
     QStringList details() const;
 
+    /**
+     * Duration of the last activation of this connection, shown in details
+     * @total - milliseconds from the request to the activated state
+     * @auth - milliseconds of it spent waiting for secrets
+     */
+    void setActivationTime(qint64 total, qint64 auth);
+
     QString deviceName() const;
     void setDeviceName(const QString& name);
 
@@ -134,6 +141,8 @@ private:
     QString m_uuid;
     QString m_vpnType;
     NetworkManager::VpnConnection::State m_vpnState;
+    qint64 m_activationTime;
+    qint64 m_activationAuthTime;
 };
 
 #endif // PLASMA_NM_MODEL_NETWORK_MODEL_ITEM_H
@@ -31,6 +31,7 @@
 #include <KSharedConfig>
 
 #include <NetworkManagerQt/BluetoothDevice>
+#include <NetworkManagerQt/GenericTypes>
 #include <NetworkManagerQt/Manager>
 #include <NetworkManagerQt/Device>
 #include <NetworkManagerQt/AccessPoint>
@@ -49,6 +50,7 @@
 // Qt
 #include <QSizeF>
 #include <QHostAddress>
+#include <QMetaType>
 
 #include <QString>
 
@@ -677,3 +679,51 @@ QString UiUtils::formatLastUsedDateRelative(const QDateTime & lastUsed)
     }
     return lastUsedText;
 }
+
+static bool operator==(const IpV6DBusAddress &address1, const IpV6DBusAddress &address2)
+{
+    return address1.address == address2.address && address1.prefix == address2.prefix && address1.gateway == address2.gateway;
+}
+
+static bool operator==(const IpV6DBusRoute &route1, const IpV6DBusRoute &route2)
+{
+    return route1.destination == route2.destination && route1.prefix == route2.prefix
+        && route1.nexthop == route2.nexthop && route1.metric == route2.metric;
+}
+
+// QVariant compares types without a registered comparator byte by byte, which for
+// containers compares their data pointers, so separately built settings never match
+static bool registerSettingComparators()
+{
+    QMetaType::registerEqualsComparator<UIntList>();
+    QMetaType::registerEqualsComparator<UIntListList>();
+    QMetaType::registerEqualsComparator<NMVariantMapList>();
+    QMetaType::registerEqualsComparator<NMStringMap>();
+    QMetaType::registerEqualsComparator<IpV6DBusAddressList>();
+    QMetaType::registerEqualsComparator<IpV6DBusRouteList>();
+    QMetaType::registerEqualsComparator<IpV6DBusNameservers>();
+    return true;
+}
+
+NMVariantMapMap UiUtils::changedSettings(const NMVariantMapMap &original, const NMVariantMapMap &edited)
+{
+    static const bool comparatorsRegistered = registerSettingComparators();
+    Q_UNUSED(comparatorsRegistered)
+
+    NMVariantMapMap changed;
+
+    for (NMVariantMapMap::const_iterator it = edited.constBegin(); it != edited.constEnd(); ++it) {
+        NMVariantMapMap::const_iterator originalIt = original.constFind(it.key());
+        if (originalIt == original.constEnd() || originalIt.value() != it.value()) {
+            changed.insert(it.key(), it.value());
+        }
+    }
+
+    for (NMVariantMapMap::const_iterator it = original.constBegin(); it != original.constEnd(); ++it) {
+        if (!edited.contains(it.key())) {
+            changed.insert(it.key(), QVariantMap());
+        }
+    }
+
+    return changed;
+}
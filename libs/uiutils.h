@@ -24,6 +24,7 @@
 
 
 #include <NetworkManagerQt/Device>
+#include <NetworkManagerQt/GenericTypes>
 #include <NetworkManagerQt/ModemDevice>
 #include <NetworkManagerQt/WirelessDevice>
 #include <NetworkManagerQt/WirelessSetting>
@@ -129,5 +130,11 @@ public:
 
     static QString formatDateRelative(const QDateTime & lastUsed);
     static QString formatLastUsedDateRelative(const QDateTime & lastUsed);
+
+    /**
+     * @brief changedSettings compares connection settings setting by setting
+     * @return settings from edited which differ from original, settings missing in edited are returned empty
+     */
+    static NMVariantMapMap changedSettings(const NMVariantMapMap &original, const NMVariantMapMap &edited);
 };
 #endif // UIUTILS_H